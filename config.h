@@ -25,6 +25,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define SESSION_MANAGER__CONFIG_H
 
 #include <cstdint>
+#include <string>
 
 namespace session_manager
 {
@@ -33,6 +34,15 @@ struct Config
     uint16_t    expiration_time_min;    // in minutes
     uint16_t    max_sessions_per_user;
     bool        postpone_expiration;
+    bool        use_thread_cache = false;   // cache recent validations per thread
+
+    // global limits, only the config passed to SessionManager::init() is used
+    uint32_t    max_sessions = 0;           // 0 - unlimited
+    uint32_t    max_memory_kb = 0;          // estimated memory of all sessions, 0 - unlimited
+    bool        evict_on_overflow = false;  // false - reject new logins, true - remove sessions closest to expiry
+    uint32_t    filter_size = 0;            // counters in the filter of unknown session ids, 0 - disabled
+    std::string stats_file;                 // memory-mapped file for external monitoring, empty - disabled
+    uint16_t    stats_interval_sec = 1;     // interval of stats file updates
 };
 
 }
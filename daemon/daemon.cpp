@@ -0,0 +1,924 @@
+/*
+
+Session daemon.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+// Serves authenticate, validate and close requests of local non-C++ services over a Unix-domain
+// or a loopback TCP socket, see protocol.h for the wire format.
+//
+// A single thread runs an epoll loop. All complete requests which arrived with one readiness event
+// are executed together: validations are passed to the manager as one batch per namespace,
+// so pipelining clients pay for the lock and the syscalls once per batch.
+//
+// Logins verify passwords, which may be slow, so they are passed to worker threads via authenticate_async().
+// The responses of a connection wait in a queue until the responses of all earlier requests are ready,
+// a worker puts a finished login into the completion queue of the server and wakes the loop up with an eventfd.
+
+#include "session_manager/session_manager.h"    // session_manager::SessionManager
+#include "session_manager/i_authenticator.h"    // session_manager::IAuthenticator
+#include "session_manager/i_executor.h"         // session_manager::IExecutor
+#include "session_manager/init_config.h"        // session_manager::init_config
+#include "session_manager/daemon/protocol.h"    // session_manager::protocol
+#include "config_reader/config_reader.h"        // config_reader::ConfigReader
+
+#include <iostream>             // std::cout
+#include <fstream>              // std::ifstream
+#include <map>                  // std::map
+#include <vector>               // std::vector
+#include <deque>                // std::deque
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <stdexcept>            // std::runtime_error
+#include <cstring>              // memset
+#include <cerrno>               // errno
+#include <csignal>              // signal
+#include <unistd.h>             // close
+#include <sys/epoll.h>          // epoll_create1
+#include <sys/eventfd.h>        // eventfd
+#include <sys/socket.h>         // socket
+#include <sys/un.h>             // sockaddr_un
+#include <netinet/in.h>         // sockaddr_in
+#include <netinet/tcp.h>        // TCP_NODELAY
+#include <arpa/inet.h>          // inet_pton
+
+#define MAX_EVENTS              256
+#define READ_CHUNK_SIZE         65536
+#define MAX_READ_PER_EVENT      ( 4 * READ_CHUNK_SIZE )     // keeps the loop fair to other connections
+#define MAX_OUTPUT_SIZE         ( 1024 * 1024 )             // reading is paused while more output is pending
+#define MAX_PENDING_RESPONSES   4096                        // reading is paused while more logins are in progress
+#define NUM_WORKERS             4                           // threads which verify the passwords of logins
+
+namespace protocol = session_manager::protocol;
+
+namespace
+{
+
+volatile std::sig_atomic_t  is_stopped = 0;
+
+void on_signal( int )
+{
+    is_stopped = 1;
+}
+
+}
+
+// checks passwords from a file with lines "<user_id> <password>", accepts everybody only if explicitly requested
+class Authenticator: public session_manager::IAuthenticator
+{
+public:
+
+    Authenticator( const std::string & filename, bool is_insecure ):
+        is_insecure_( is_insecure )
+    {
+        if( is_insecure_ )
+            return;
+
+        std::ifstream in( filename );
+
+        if( in.is_open() == false )
+            throw std::runtime_error( "cannot open users file " + filename );
+
+        uint32_t    user_id;
+        std::string password;
+
+        while( in >> user_id >> password )
+            map_user_to_password_[ user_id ] = password;
+
+        if( map_user_to_password_.empty() )
+            throw std::runtime_error( "no users in " + filename );
+    }
+
+    // interface session_manager::IAuthenticator
+    virtual bool is_authenticated( uint32_t user_id, const std::string & password ) const
+    {
+        if( is_insecure_ )
+            return true;
+
+        auto it = map_user_to_password_.find( user_id );
+
+        return it != map_user_to_password_.end() && it->second == password;
+    }
+
+    // the map is only read after the construction
+    virtual bool is_thread_safe() const
+    {
+        return true;
+    }
+
+private:
+
+    bool                            is_insecure_;
+
+    std::map<uint32_t,std::string>  map_user_to_password_;
+};
+
+// runs the tasks on a fixed number of threads, the tasks which have not started yet are dropped on stop
+class WorkerExecutor: public session_manager::IExecutor
+{
+public:
+
+    WorkerExecutor( uint32_t num_threads ):
+        is_stopped_( false )
+    {
+        for( uint32_t i = 0; i < num_threads; ++i )
+            threads_.push_back( std::thread( [this]() { run(); } ) );
+    }
+
+    ~WorkerExecutor()
+    {
+        stop();
+    }
+
+    // interface session_manager::IExecutor
+    virtual void post( const std::function<void()> & task )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+
+            tasks_.push_back( task );
+        }
+
+        cond_.notify_one();
+    }
+
+    // waits for the running tasks
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+
+            is_stopped_ = true;
+        }
+
+        cond_.notify_all();
+
+        for( auto & t : threads_ )
+        {
+            if( t.joinable() )
+                t.join();
+        }
+    }
+
+private:
+
+    void run()
+    {
+        while( true )
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock( mutex_ );
+
+                cond_.wait( lock, [this]() { return is_stopped_ || tasks_.empty() == false; } );
+
+                if( is_stopped_ )
+                    return;
+
+                task = tasks_.front();
+
+                tasks_.pop_front();
+            }
+
+            task();
+        }
+    }
+
+private:
+
+    std::mutex                          mutex_;
+    std::condition_variable             cond_;
+    std::deque<std::function<void()>>   tasks_;
+    bool                                is_stopped_;
+
+    std::vector<std::thread>            threads_;
+};
+
+class Server
+{
+public:
+
+    Server( session_manager::SessionManager & m ):
+        m_( m ),
+        listen_fd_( -1 ),
+        epoll_fd_( -1 ),
+        wakeup_fd_( -1 ),
+        last_connection_id_( 0 ),
+        num_requests_( 0 ),
+        num_batches_( 0 ),
+        executor_( NUM_WORKERS )
+    {
+    }
+
+    ~Server()
+    {
+        // the workers must not complete logins into a destroyed server
+        executor_.stop();
+
+        for( auto & c : map_connections_ )
+            close( c.first );
+
+        if( listen_fd_ >= 0 )
+            close( listen_fd_ );
+
+        if( epoll_fd_ >= 0 )
+            close( epoll_fd_ );
+
+        if( wakeup_fd_ >= 0 )
+            close( wakeup_fd_ );
+
+        if( unix_path_.empty() == false )
+            unlink( unix_path_.c_str() );
+    }
+
+    // address is either a path of a Unix-domain socket or <ip>:<port> of a loopback interface
+    void init( const std::string & address )
+    {
+        listen_fd_ = create_listen_socket( address );
+
+        epoll_fd_ = epoll_create1( 0 );
+
+        if( epoll_fd_ < 0 )
+            throw std::runtime_error( "epoll_create1 failed, errno " + std::to_string( errno ) );
+
+        add_to_epoll( listen_fd_, EPOLLIN );
+
+        wakeup_fd_ = eventfd( 0, EFD_NONBLOCK );
+
+        if( wakeup_fd_ < 0 )
+            throw std::runtime_error( "eventfd failed, errno " + std::to_string( errno ) );
+
+        add_to_epoll( wakeup_fd_, EPOLLIN );
+    }
+
+    void run()
+    {
+        epoll_event events[ MAX_EVENTS ];
+
+        while( is_stopped == 0 )
+        {
+            int n = epoll_wait( epoll_fd_, events, MAX_EVENTS, 1000 );
+
+            if( n < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+
+                throw std::runtime_error( "epoll_wait failed, errno " + std::to_string( errno ) );
+            }
+
+            for( int i = 0; i < n; ++i )
+            {
+                int fd = events[i].data.fd;
+
+                if( fd == listen_fd_ )
+                {
+                    accept_connections();
+                    continue;
+                }
+
+                if( fd == wakeup_fd_ )
+                {
+                    handle_completions();
+                    continue;
+                }
+
+                auto it = map_connections_.find( fd );
+
+                if( it == map_connections_.end() )
+                    continue;
+
+                if( handle_event( it->second, events[i].events ) == false )
+                    close_connection( fd );
+            }
+        }
+
+        std::cout << "stopped: requests " << num_requests_ << ", batches " << num_batches_ << std::endl;
+    }
+
+private:
+
+    struct Response
+    {
+        protocol::status_e  status;
+        std::string         payload;
+    };
+
+    // response of a request in the order of the requests, a login is not ready until a worker finished it
+    struct PendingResponse
+    {
+        bool                is_ready;
+        Response            response;
+    };
+
+    struct Connection
+    {
+        int             fd;
+        uint64_t        id;                 // unlike fd, never reused, so late logins of a closed connection are dropped
+        bool            is_reading_paused;
+        bool            is_input_closed;
+        std::string     input;
+        std::string     output;
+        std::size_t     output_offset;
+
+        std::deque<PendingResponse> pending;
+        uint64_t                    first_pending_seq;  // sequence number of the request of pending.front()
+    };
+
+    // login finished by a worker
+    struct Completion
+    {
+        int             fd;
+        uint64_t        connection_id;
+        uint64_t        seq;
+        Response        response;
+    };
+
+    struct Request
+    {
+        protocol::opcode_e  opcode;
+        uint16_t            ns;
+        const char          * payload;
+        uint32_t            payload_size;
+    };
+
+    // requests which are executed together, namespace -> indices of requests
+    struct Batch
+    {
+        std::map<uint16_t,std::vector<std::size_t>> validations;
+    };
+
+private:
+
+    int create_listen_socket( const std::string & address )
+    {
+        auto pos = address.rfind( ':' );
+
+        bool is_tcp = ( pos != std::string::npos && address.find( '/' ) == std::string::npos );
+
+        int fd = socket( is_tcp ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0 );
+
+        if( fd < 0 )
+            throw std::runtime_error( "cannot create socket, errno " + std::to_string( errno ) );
+
+        int res;
+
+        if( is_tcp )
+        {
+            sockaddr_in addr;
+
+            memset( & addr, 0, sizeof( addr ) );
+
+            addr.sin_family = AF_INET;
+            addr.sin_port   = htons( std::stoul( address.substr( pos + 1 ) ) );
+
+            if( inet_pton( AF_INET, address.substr( 0, pos ).c_str(), & addr.sin_addr ) != 1 )
+                throw std::runtime_error( "invalid address " + address );
+
+            if( ( ntohl( addr.sin_addr.s_addr ) >> 24 ) != 127 )
+                throw std::runtime_error( "only loopback addresses are allowed: " + address );
+
+            int on = 1;
+
+            setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, & on, sizeof( on ) );
+
+            res = bind( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) );
+        }
+        else
+        {
+            sockaddr_un addr;
+
+            if( address.size() >= sizeof( addr.sun_path ) )
+                throw std::runtime_error( "socket path is too long: " + address );
+
+            memset( & addr, 0, sizeof( addr ) );
+
+            addr.sun_family = AF_UNIX;
+
+            memcpy( addr.sun_path, address.c_str(), address.size() );
+
+            unlink( address.c_str() );
+
+            res = bind( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) );
+
+            unix_path_ = address;
+        }
+
+        if( res != 0 || listen( fd, SOMAXCONN ) != 0 )
+        {
+            close( fd );
+            throw std::runtime_error( "cannot listen on " + address + ", errno " + std::to_string( errno ) );
+        }
+
+        return fd;
+    }
+
+    void add_to_epoll( int fd, uint32_t events )
+    {
+        epoll_event ev;
+
+        ev.events   = events;
+        ev.data.fd  = fd;
+
+        if( epoll_ctl( epoll_fd_, EPOLL_CTL_ADD, fd, & ev ) != 0 )
+            throw std::runtime_error( "epoll_ctl failed, errno " + std::to_string( errno ) );
+    }
+
+    void update_epoll( Connection & c )
+    {
+        epoll_event ev;
+
+        ev.events   = ( c.is_reading_paused ? 0u : uint32_t( EPOLLIN ) ) | ( c.output.empty() ? 0u : uint32_t( EPOLLOUT ) );
+        ev.data.fd  = c.fd;
+
+        epoll_ctl( epoll_fd_, EPOLL_CTL_MOD, c.fd, & ev );
+    }
+
+    void accept_connections()
+    {
+        while( true )
+        {
+            int fd = accept4( listen_fd_, nullptr, nullptr, SOCK_NONBLOCK );
+
+            if( fd < 0 )
+                return;
+
+            int on = 1;
+
+            // fails harmlessly for Unix-domain sockets
+            setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, & on, sizeof( on ) );
+
+            auto & c = map_connections_[ fd ];
+
+            c.fd                = fd;
+            c.id                = ++last_connection_id_;
+            c.is_reading_paused = false;
+            c.is_input_closed   = false;
+            c.output_offset     = 0;
+            c.first_pending_seq = 0;
+
+            add_to_epoll( fd, EPOLLIN );
+        }
+    }
+
+    void close_connection( int fd )
+    {
+        epoll_ctl( epoll_fd_, EPOLL_CTL_DEL, fd, nullptr );
+
+        close( fd );
+
+        map_connections_.erase( fd );
+    }
+
+    // returns false if the connection has to be closed
+    bool handle_event( Connection & c, uint32_t events )
+    {
+        if( ( events & ( EPOLLERR | EPOLLHUP ) ) && ( events & EPOLLIN ) == 0 )
+            return false;
+
+        if( ( events & EPOLLIN ) && c.is_input_closed == false )
+        {
+            if( read_input( c, & c.is_input_closed ) == false )
+                return false;
+
+            if( process_input( c ) == false )
+                return false;
+        }
+
+        return send_output( c, ( events & EPOLLOUT ) != 0 );
+    }
+
+    // returns false if the connection has to be closed
+    bool send_output( Connection & c, bool is_epollout )
+    {
+        if( write_output( c ) == false )
+            return false;
+
+        // the client may half-close the connection after pipelining its requests,
+        // so it is closed only once all responses were sent
+        if( c.is_input_closed && c.output.empty() && c.pending.empty() )
+            return false;
+
+        bool is_reading_paused = c.is_input_closed || c.output.size() - c.output_offset > MAX_OUTPUT_SIZE
+                || c.pending.size() > MAX_PENDING_RESPONSES;
+
+        if( is_reading_paused != c.is_reading_paused || is_epollout || c.output.empty() == false )
+        {
+            c.is_reading_paused = is_reading_paused;
+
+            update_epoll( c );
+        }
+
+        return true;
+    }
+
+    // called by the workers
+    void complete( const Completion & completion )
+    {
+        bool is_first;
+
+        {
+            std::lock_guard<std::mutex> lock( completions_mutex_ );
+
+            is_first = completions_.empty();
+
+            completions_.push_back( completion );
+        }
+
+        // the loop takes all completions at once, so one wakeup is enough for all which arrive meanwhile
+        if( is_first )
+        {
+            uint64_t one = 1;
+
+            auto res = write( wakeup_fd_, & one, sizeof( one ) );
+
+            ( void )res;
+        }
+    }
+
+    void handle_completions()
+    {
+        uint64_t value;
+
+        auto res = read( wakeup_fd_, & value, sizeof( value ) );
+
+        ( void )res;
+
+        std::vector<Completion> completions;
+
+        {
+            std::lock_guard<std::mutex> lock( completions_mutex_ );
+
+            completions.swap( completions_ );
+        }
+
+        std::vector<int> fds;
+
+        for( auto & e : completions )
+        {
+            auto it = map_connections_.find( e.fd );
+
+            if( it == map_connections_.end() || it->second.id != e.connection_id )
+                continue;
+
+            auto & c = it->second;
+
+            auto & p = c.pending[ e.seq - c.first_pending_seq ];
+
+            p.is_ready  = true;
+            p.response  = e.response;
+
+            flush_pending( c );
+
+            fds.push_back( e.fd );
+        }
+
+        for( auto fd : fds )
+        {
+            auto it = map_connections_.find( fd );
+
+            // already closed because of an earlier completion
+            if( it == map_connections_.end() )
+                continue;
+
+            // EPOLLOUT may be set while the output is empty now, so the interest is always updated
+            if( send_output( it->second, true ) == false )
+                close_connection( fd );
+        }
+    }
+
+    // moves the ready responses at the front of the queue into the output
+    void flush_pending( Connection & c )
+    {
+        while( c.pending.empty() == false && c.pending.front().is_ready )
+        {
+            auto & r = c.pending.front().response;
+
+            protocol::append_response( & c.output, r.status, r.payload );
+
+            c.pending.pop_front();
+
+            ++c.first_pending_seq;
+        }
+    }
+
+    bool read_input( Connection & c, bool * is_closed )
+    {
+        std::size_t total = 0;
+
+        while( total < MAX_READ_PER_EVENT )
+        {
+            auto size = c.input.size();
+
+            c.input.resize( size + READ_CHUNK_SIZE );
+
+            auto res = read( c.fd, & c.input[ size ], READ_CHUNK_SIZE );
+
+            c.input.resize( size + ( res > 0 ? res : 0 ) );
+
+            if( res == 0 )
+            {
+                * is_closed = true;
+                return true;
+            }
+
+            if( res < 0 )
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+            total += res;
+        }
+
+        return true;
+    }
+
+    bool process_input( Connection & c )
+    {
+        std::vector<Request> requests;
+
+        std::size_t pos = 0;
+
+        while( c.input.size() - pos >= protocol::HEADER_SIZE )
+        {
+            auto size = protocol::read_uint32( & c.input[ pos ] );
+
+            if( size < protocol::REQUEST_HEADER_SIZE || size > protocol::MAX_BODY_SIZE )
+                return false;
+
+            if( c.input.size() - pos - protocol::HEADER_SIZE < size )
+                break;
+
+            const char * body = & c.input[ pos + protocol::HEADER_SIZE ];
+
+            Request r;
+
+            r.opcode        = static_cast<protocol::opcode_e>( body[0] );
+            r.ns            = protocol::read_uint16( body + 1 );
+            r.payload       = body + protocol::REQUEST_HEADER_SIZE;
+            r.payload_size  = size - protocol::REQUEST_HEADER_SIZE;
+
+            requests.push_back( r );
+
+            pos += protocol::HEADER_SIZE + size;
+        }
+
+        if( requests.empty() )
+            return true;
+
+        execute( c, requests );
+
+        c.input.erase( 0, pos );
+
+        return true;
+    }
+
+    void execute( Connection & c, const std::vector<Request> & requests )
+    {
+        std::vector<PendingResponse> responses( requests.size() );
+
+        Batch batch;
+
+        // sequence number of the first request
+        auto seq = c.first_pending_seq + c.pending.size();
+
+        for( std::size_t i = 0; i < requests.size(); ++i )
+        {
+            auto & r = requests[i];
+
+            responses[i].is_ready = true;
+
+            switch( r.opcode )
+            {
+            case protocol::VALIDATE:
+                batch.validations[ r.ns ].push_back( i );
+                break;
+
+            case protocol::AUTHENTICATE:
+                if( r.payload_size < sizeof( uint32_t ) )
+                {
+                    responses[i].response.status = protocol::BAD_REQUEST;
+                }
+                else
+                {
+                    responses[i].is_ready = false;
+
+                    start_login( c, seq + i, r );
+                }
+                break;
+
+            case protocol::CLOSE:
+            {
+                // a close must not overtake earlier validations of the pipeline, the logins in progress
+                // cannot be affected by it, as the client does not know their session ids yet
+                execute_batch( & responses, & batch, requests );
+
+                std::string error;
+
+                if( m_.close_session( std::string( r.payload, r.payload_size ), error, r.ns ) )
+                {
+                    responses[i].response.status = protocol::OK;
+                }
+                else
+                {
+                    responses[i].response.status    = protocol::FAILED;
+                    responses[i].response.payload   = error;
+                }
+                break;
+            }
+
+            default:
+                responses[i].response.status = protocol::BAD_REQUEST;
+                break;
+            }
+        }
+
+        execute_batch( & responses, & batch, requests );
+
+        for( auto & r : responses )
+            c.pending.push_back( r );
+
+        flush_pending( c );
+
+        num_requests_ += requests.size();
+    }
+
+    void start_login( const Connection & c, uint64_t seq, const Request & r )
+    {
+        auto user_id = protocol::read_uint32( r.payload );
+
+        std::string password( r.payload + sizeof( uint32_t ), r.payload_size - sizeof( uint32_t ) );
+
+        int         fd              = c.fd;
+        uint64_t    connection_id   = c.id;
+
+        m_.authenticate_async( & executor_, user_id, password,
+                [this, fd, connection_id, seq]( bool is_ok, const std::string & session_id, const std::string & error )
+                {
+                    Completion e;
+
+                    e.fd                = fd;
+                    e.connection_id     = connection_id;
+                    e.seq               = seq;
+                    e.response.status   = is_ok ? protocol::OK : protocol::FAILED;
+                    e.response.payload  = is_ok ? session_id : error;
+
+                    complete( e );
+                },
+                r.ns );
+    }
+
+    void execute_batch( std::vector<PendingResponse> * responses, Batch * batch, const std::vector<Request> & requests )
+    {
+        for( auto & b : batch->validations )
+        {
+            std::vector<std::string> session_ids( b.second.size() );
+
+            for( std::size_t j = 0; j < b.second.size(); ++j )
+            {
+                auto & r = requests[ b.second[j] ];
+
+                session_ids[j].assign( r.payload, r.payload_size );
+            }
+
+            std::vector<uint8_t>                        results;
+            std::vector<session_manager::user_id_t>     user_ids;
+
+            m_.is_authenticated_batch( & results, & user_ids, session_ids, b.first );
+
+            for( std::size_t j = 0; j < b.second.size(); ++j )
+            {
+                auto & resp = ( * responses )[ b.second[j] ].response;
+
+                if( results[j] )
+                {
+                    resp.status = protocol::OK;
+                    protocol::append_uint32( & resp.payload, user_ids[j] );
+                }
+                else
+                {
+                    resp.status = protocol::FAILED;
+                }
+            }
+
+            ++num_batches_;
+        }
+
+        batch->validations.clear();
+    }
+
+    bool write_output( Connection & c )
+    {
+        while( c.output_offset < c.output.size() )
+        {
+            auto res = send( c.fd, c.output.data() + c.output_offset, c.output.size() - c.output_offset, MSG_NOSIGNAL );
+
+            if( res < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+
+            c.output_offset += res;
+        }
+
+        c.output.clear();
+        c.output_offset = 0;
+
+        return true;
+    }
+
+private:
+
+    session_manager::SessionManager & m_;
+
+    int                 listen_fd_;
+    int                 epoll_fd_;
+    int                 wakeup_fd_;         // eventfd, written by the workers when they finish logins
+    std::string         unix_path_;
+
+    std::map<int,Connection>    map_connections_;
+
+    uint64_t            last_connection_id_;
+
+    uint64_t            num_requests_;
+    uint64_t            num_batches_;
+
+    std::mutex                  completions_mutex_;
+    std::vector<Completion>     completions_;
+
+    WorkerExecutor      executor_;
+};
+
+int main( int argc, char ** argv )
+{
+    if( argc != 4 )
+    {
+        std::cout << "USAGE: session_daemon <config.ini> <socket_path | 127.0.0.1:port> <users_file | --insecure>\n"
+                << "       --insecure accepts any password, for benchmarks only" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        config_reader::ConfigReader cr;
+
+        cr.init( argv[1] );
+
+        session_manager::Config cfg;
+
+        session_manager::init_config( & cfg, "session_manager", cr );
+
+        std::string users_file( argv[3] );
+
+        bool is_insecure = ( users_file == "--insecure" );
+
+        Authenticator a( users_file, is_insecure );
+
+        if( is_insecure )
+            std::cout << "WARNING: --insecure: any password is accepted" << std::endl;
+
+        session_manager::SessionManager m;
+
+        m.init( & a, cfg );
+
+        signal( SIGINT, on_signal );
+        signal( SIGTERM, on_signal );
+
+        Server server( m );
+
+        server.init( argv[2] );
+
+        std::cout << "listening on " << argv[2] << std::endl;
+
+        server.run();
+
+        return 0;
+    }
+    catch( std::exception & e )
+    {
+        std::cout << "ERROR: " << e.what() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+}
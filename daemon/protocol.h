@@ -0,0 +1,119 @@
+/*
+
+Session daemon protocol.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__DAEMON__PROTOCOL_H
+#define SESSION_MANAGER__DAEMON__PROTOCOL_H
+
+#include <cstdint>      // uint32_t
+#include <cstring>      // memcpy
+#include <string>       // std::string
+
+// Every message is a frame: uint32 length of the body, followed by the body.
+// Integers are in the host byte order, as the daemon is reached over a local socket only.
+//
+// Request body:  uint8 opcode, uint16 namespace, payload
+//
+//   AUTHENTICATE   uint32 user_id, password (rest of the body)
+//   VALIDATE       session id (rest of the body)
+//   CLOSE          session id (rest of the body)
+//
+// Response body: uint8 status, payload
+//
+//   AUTHENTICATE   OK: session id, FAILED: error
+//   VALIDATE       OK: uint32 user_id, FAILED: empty
+//   CLOSE          OK: empty, FAILED: error
+//
+// Requests can be pipelined, the responses are sent in the order of the requests.
+
+namespace session_manager
+{
+
+namespace protocol
+{
+
+enum opcode_e : uint8_t
+{
+    AUTHENTICATE    = 1,
+    VALIDATE        = 2,
+    CLOSE           = 3,
+};
+
+enum status_e : uint8_t
+{
+    OK              = 0,
+    FAILED          = 1,
+    BAD_REQUEST     = 2,
+};
+
+const uint32_t HEADER_SIZE          = sizeof( uint32_t );
+const uint32_t REQUEST_HEADER_SIZE  = sizeof( uint8_t ) + sizeof( uint16_t );
+const uint32_t MAX_BODY_SIZE        = 4096;
+
+inline void append_uint32( std::string * buffer, uint32_t v )
+{
+    buffer->append( reinterpret_cast<const char*>( & v ), sizeof( v ) );
+}
+
+inline void append_uint16( std::string * buffer, uint16_t v )
+{
+    buffer->append( reinterpret_cast<const char*>( & v ), sizeof( v ) );
+}
+
+inline uint32_t read_uint32( const char * p )
+{
+    uint32_t res;
+
+    memcpy( & res, p, sizeof( res ) );
+
+    return res;
+}
+
+inline uint16_t read_uint16( const char * p )
+{
+    uint16_t res;
+
+    memcpy( & res, p, sizeof( res ) );
+
+    return res;
+}
+
+inline void append_request( std::string * buffer, opcode_e opcode, uint16_t ns, const std::string & payload )
+{
+    append_uint32( buffer, REQUEST_HEADER_SIZE + payload.size() );
+    buffer->push_back( static_cast<char>( opcode ) );
+    append_uint16( buffer, ns );
+    buffer->append( payload );
+}
+
+inline void append_response( std::string * buffer, status_e status, const std::string & payload )
+{
+    append_uint32( buffer, sizeof( uint8_t ) + payload.size() );
+    buffer->push_back( static_cast<char>( status ) );
+    buffer->append( payload );
+}
+
+} // namespace protocol
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__DAEMON__PROTOCOL_H
@@ -24,10 +24,23 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "session_manager/session_manager.h"       // session_manager::SessionManager
 #include "i_authenticator.h"    // session_manager::IAuthenticator
 #include "init_config.h"        // session_manager::init_config
+#include "manual_clock.h"       // session_manager::ManualClock
+#include "session_handoff.h"    // session_manager::export_sessions
+#include "session_awaitable.h"  // session_manager::authenticate_co
+#include "i_executor.h"         // session_manager::IExecutor
+#include "session_id.h"         // session_manager::parse_session_id
 #include "config_reader/config_reader.h"    // config_reader::ConfigReader
 
 #include <iostream>             // std::cout
-#include <thread>               // std::this_thread
+#include <thread>               // std::thread
+#include <atomic>               // std::atomic
+#include <mutex>                // std::mutex
+#include <deque>                // std::deque
+#include <condition_variable>   // std::condition_variable
+#include <cstdio>               // snprintf
+#include <exception>            // std::terminate
+#include <sys/socket.h>         // socketpair
+#include <unistd.h>             // close
 
 class Authenticator: public session_manager::IAuthenticator
 {
@@ -66,6 +79,89 @@ private:
     Map map_user_to_pwd_hash_;
 };
 
+// not thread-safe on purpose: records the largest number of concurrent calls
+class SlowAuthenticator: public session_manager::IAuthenticator
+{
+public:
+
+    SlowAuthenticator():
+        num_active_( 0 ),
+        max_active_( 0 )
+    {
+    }
+
+    // interface session_manager::IAuthenticator
+    virtual bool is_authenticated( uint32_t user_id, const std::string & password ) const
+    {
+        auto num = ++num_active_;
+
+        if( num > max_active_ )
+            max_active_ = num;
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+        --num_active_;
+
+        return true;
+    }
+
+    uint32_t get_max_active() const
+    {
+        return max_active_;
+    }
+
+private:
+
+    mutable std::atomic<uint32_t>   num_active_;
+    mutable std::atomic<uint32_t>   max_active_;
+};
+
+// runs the posted tasks only when it is drained, so that the test decides when the work happens;
+// a thread pool or the loop of an event-driven shard plays this role in a service
+class QueueExecutor: public session_manager::IExecutor
+{
+public:
+
+    // interface session_manager::IExecutor
+    virtual void post( const std::function<void()> & task )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        tasks_.push_back( task );
+    }
+
+    // runs the posted tasks including the ones posted by them, returns the number of tasks run
+    uint32_t run()
+    {
+        uint32_t num = 0;
+
+        while( true )
+        {
+            std::function<void()> task;
+
+            {
+                std::lock_guard<std::mutex> lock( mutex_ );
+
+                if( tasks_.empty() )
+                    return num;
+
+                task = tasks_.front();
+
+                tasks_.pop_front();
+            }
+
+            task();
+
+            ++num;
+        }
+    }
+
+private:
+
+    std::mutex                          mutex_;
+    std::deque<std::function<void()>>   tasks_;
+};
+
 void test_auth( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
 {
     std::cout << "testing: user = " << user_id << ", password = " << password << std::endl;
@@ -199,6 +295,70 @@ void test_close_wrong_id( session_manager::SessionManager & m )
     }
 }
 
+void test_parse_session_id()
+{
+    const std::string valid = "b3ef4ab3-2c1c-4590-8d9c-a764eb068dbf";
+
+    struct Case
+    {
+        std::string     text;
+        bool            is_valid;
+    };
+
+    const Case cases[] =
+    {
+        { valid,                                    true },
+        { "B3EF4AB3-2C1C-4590-8D9C-A764EB068DBF",   false },    // upper-case hex
+        { "b3ef4ab3-2c1c-4590-8d9c-a764eb068dbF",   false },
+        { "b3ef4ab32-c1c-4590-8d9c-a764eb068dbf",   false },    // misplaced dashes
+        { "b3ef4ab3-2c1c-45908-d9c-a764eb068dbf",   false },
+        { "b3ef4ab3-2c1c-4590-8d9ca-764eb068dbf",   false },
+        { "b3ef4ab3f2c1cf4590f8d9cfa764eb068dbf",   false },
+        { "b3ef4ab3-2c1c-4590-8d9c-a764eb068db",    false },    // 35 characters
+        { "b3ef4ab3-2c1c-4590-8d9c-a764eb068dbf0",  false },    // 37 characters
+    };
+
+    uint32_t num_errors = 0;
+
+    auto check = [&num_errors]( const std::string & text, bool is_valid )
+    {
+        session_manager::SessionId id, id_scalar;
+
+        auto res        = session_manager::parse_session_id( & id, text );
+        auto res_scalar = session_manager::parse_session_id_scalar( & id_scalar, text );
+
+        if( res != is_valid || res_scalar != is_valid || ( res && ( id == id_scalar ) == false ) )
+            ++num_errors;
+    };
+
+    for( auto & c : cases )
+        check( c.text, c.is_valid );
+
+    // every byte value at every position, including the bytes >= 0x80 which are negative as signed chars
+    for( std::size_t i = 0; i < valid.size(); ++i )
+    {
+        for( int c = 0; c < 256; ++c )
+        {
+            auto text = valid;
+
+            text[i] = static_cast<char>( c );
+
+            bool is_dash = ( i == 8 || i == 13 || i == 18 || i == 23 );
+
+            check( text, is_dash ? c == '-' : ( ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'f' ) ) );
+        }
+    }
+
+    if( num_errors )
+    {
+        std::cout << "ERROR: vectorized and scalar parsing of session ids differ in " << num_errors << " cases" << std::endl;
+    }
+    else
+    {
+        std::cout << "OK: vectorized and scalar parsing of session ids agree" << std::endl;
+    }
+}
+
 void test_max_sessions( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
 {
     test_auth( m, user_id, password );
@@ -206,7 +366,7 @@ void test_max_sessions( session_manager::SessionManager & m, uint32_t user_id, c
     test_auth( m, user_id, password );
 }
 
-void test_expiration( session_manager::SessionManager & m, uint32_t user_id, const std::string & password, uint32_t sleep )
+void test_expiration( session_manager::SessionManager & m, session_manager::ManualClock & clock, uint32_t user_id, const std::string & password, uint32_t sleep )
 {
     std::cout << "testing: user = " << user_id << ", password = " << password << std::endl;
 
@@ -223,11 +383,9 @@ void test_expiration( session_manager::SessionManager & m, uint32_t user_id, con
 
         if( is_auth )
         {
-            std::cout << "OK: session id authenticated, sleep " << sleep << " min" << std::endl;
-
-            std::chrono::minutes timespan( sleep );
+            std::cout << "OK: session id authenticated, advance clock by " << sleep << " min" << std::endl;
 
-            std::this_thread::sleep_for( timespan );
+            clock.advance( std::chrono::minutes( sleep ) );
 
             auto is_auth2 = m.is_authenticated( id );
 
@@ -251,7 +409,7 @@ void test_expiration( session_manager::SessionManager & m, uint32_t user_id, con
     }
 }
 
-void test_remove_expired( session_manager::SessionManager & m, uint32_t user_id, const std::string & password, uint32_t sleep )
+void test_remove_expired( session_manager::SessionManager & m, session_manager::ManualClock & clock, uint32_t user_id, const std::string & password, uint32_t sleep )
 {
     std::cout << "testing: user = " << user_id << ", password = " << password << std::endl;
 
@@ -290,11 +448,9 @@ void test_remove_expired( session_manager::SessionManager & m, uint32_t user_id,
     {
         std::cout << "ERROR: " << error << std::endl;
 
-        std::cout << "OK: cannot authenticate, sleep " << sleep << " min" << std::endl;
+        std::cout << "OK: cannot authenticate, advance clock by " << sleep << " min" << std::endl;
 
-        std::chrono::minutes timespan( sleep );
-
-        std::this_thread::sleep_for( timespan );
+        clock.advance( std::chrono::minutes( sleep ) );
     }
 
     std::cout << "try: 4" << std::endl;
@@ -331,6 +487,20 @@ void test_get_session_info( session_manager::SessionManager & m, uint32_t user_i
     {
         std::cout << "OK: user authenticated: session id = " << id << std::endl;
 
+        if( m.set_attributes( id, "roles=admin;tenant=42", error ) == false )
+        {
+            std::cout << "ERROR: cannot set attributes: " << error << std::endl;
+        }
+
+        if( m.set_attributes( id, std::string( 70000, 'x' ), error ) )
+        {
+            std::cout << "ERROR: too large attributes were accepted" << std::endl;
+        }
+        else
+        {
+            std::cout << "OK: too large attributes were rejected: " << error << std::endl;
+        }
+
         session_manager::SessionManager::SessionInfo session_info;
 
         if( m.get_session_info( & session_info, id ) )
@@ -340,7 +510,8 @@ void test_get_session_info( session_manager::SessionManager & m, uint32_t user_i
             std::cout
                 << "user id         : " << session_info.user_id << "\n"
                 << "start time      : " << to_string( session_info.start_time ) << "\n"
-                << "expiration time : " << to_string( session_info.expiration_time ) << std::endl;
+                << "expiration time : " << to_string( session_info.expiration_time ) << "\n"
+                << "attributes      : " << session_info.attributes << std::endl;
         }
         else
         {
@@ -387,6 +558,602 @@ void test_get_session_info_2( session_manager::SessionManager & m, uint32_t user
     }
 }
 
+void test_get_sessions( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
+{
+    std::cout << "testing: user = " << user_id << ", password = " << password << std::endl;
+
+    std::string id;
+    std::string error;
+
+    auto b = m.authenticate( user_id, password, id, error );
+
+    if( b == false )
+    {
+        std::cout << "ERROR: " << error << std::endl;
+        return;
+    }
+
+    std::cout << "OK: user authenticated: session id = " << id << std::endl;
+
+    session_manager::SessionManager::Cursor cursor;
+
+    std::size_t num_sessions = 0;
+
+    while( cursor.is_finished == false )
+    {
+        std::vector<session_manager::SessionManager::SessionRecord> sessions;
+
+        m.get_sessions( & sessions, & cursor, 2 );
+
+        for( auto & s : sessions )
+        {
+            std::cout << "session " << s.session_id << ", user " << s.session_info.user_id << ", expires " << to_string( s.session_info.expiration_time ) << std::endl;
+        }
+
+        num_sessions += sessions.size();
+    }
+
+    std::cout << "OK: total number of sessions = " << num_sessions << std::endl;
+
+    std::vector<session_manager::SessionManager::SessionRecord> user_sessions;
+
+    m.get_user_sessions( & user_sessions, user_id );
+
+    std::cout << "OK: number of sessions of user " << user_id << " = " << user_sessions.size() << std::endl;
+
+    m.close_session( id, error );
+}
+
+void test_namespaces( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
+{
+    std::cout << "testing: user = " << user_id << ", password = " << password << std::endl;
+
+    const session_manager::namespace_id_t tenant = 1;
+
+    std::string id;
+    std::string error;
+
+    auto b = m.authenticate( user_id, password, id, error, tenant );
+
+    if( b == false )
+    {
+        std::cout << "ERROR: " << error << std::endl;
+        return;
+    }
+
+    std::cout << "OK: user authenticated in namespace " << tenant << ": session id = " << id << std::endl;
+
+    if( m.is_authenticated( id, tenant ) )
+    {
+        std::cout << "OK: session id authenticated in its namespace" << std::endl;
+    }
+    else
+    {
+        std::cout << "ERROR: session id NOT authenticated in its namespace" << std::endl;
+    }
+
+    if( m.is_authenticated( id ) )
+    {
+        std::cout << "ERROR: session id authenticated in default namespace" << std::endl;
+    }
+    else
+    {
+        std::cout << "OK: session id NOT authenticated in default namespace" << std::endl;
+    }
+
+    m.close_session( id, error, tenant );
+}
+
+void test_authenticate_batch( session_manager::SessionManager & m )
+{
+    std::cout << "testing: batch authentication" << std::endl;
+
+    std::vector<session_manager::Credentials> credentials =
+    {
+        { 1, "alpha" },
+        { 2, "wrong" },
+        { 3, "gamma" },
+    };
+
+    std::vector<session_manager::SessionManager::AuthResult> results;
+
+    m.authenticate_batch( & results, credentials );
+
+    for( std::size_t i = 0; i < results.size(); ++i )
+    {
+        if( results[i].is_ok )
+        {
+            std::cout << "OK: user " << credentials[i].user_id << " authenticated: session id = " << results[i].session_id << std::endl;
+
+            std::string error;
+
+            m.close_session( results[i].session_id, error );
+        }
+        else
+        {
+            std::cout << "user " << credentials[i].user_id << " NOT authenticated: " << results[i].error << std::endl;
+        }
+    }
+}
+
+// generated ids in the canonical form, spread over the whole range of ids
+std::string make_session_id( uint32_t i )
+{
+    char buf[40];
+
+    snprintf( buf, sizeof( buf ), "%08x-%04x-4000-8000-%012x", i * 2654435761u, i & 0xFFFF, i );
+
+    return buf;
+}
+
+void test_handoff( session_manager::IAuthenticator * auth, const session_manager::Config & cfg, uint32_t user_id, const std::string & password )
+{
+    std::cout << "testing: session handoff" << std::endl;
+
+    const uint32_t num_sessions = 20000;    // the stream must not fit into the buffers of the sockets
+
+    session_manager::ManualClock clock( std::chrono::system_clock::now() );
+
+    session_manager::Config c = cfg;
+
+    c.expiration_time_min   = 60;
+    c.postpone_expiration   = true;
+    c.max_sessions          = 0;
+    c.max_memory_kb         = 0;
+
+    session_manager::SessionManager m1;
+    session_manager::SessionManager m2;
+
+    m1.init( auth, c, & clock );
+    m2.init( auth, c, & clock );
+
+    std::vector<session_manager::SessionManager::SessionRecord> records( num_sessions );
+
+    for( uint32_t i = 0; i < num_sessions; ++i )
+    {
+        auto & r = records[i];
+
+        r.session_id                        = make_session_id( i );
+        r.session_info.namespace_id         = session_manager::SessionManager::DEFAULT_NAMESPACE;
+        r.session_info.user_id              = 100 + i;
+        r.session_info.start_time           = clock.get_now();
+        r.session_info.expiration_time      = clock.get_now() + std::chrono::minutes( c.expiration_time_min );
+    }
+
+    m1.import_sessions( records );
+
+    clock.advance( std::chrono::minutes( 1 ) );
+
+    int fds_out[2];
+    int fds_in[2];
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, fds_out ) != 0 || socketpair( AF_UNIX, SOCK_STREAM, 0, fds_in ) != 0 )
+    {
+        std::cout << "ERROR: cannot create socket pair" << std::endl;
+        return;
+    }
+
+    std::atomic<bool>   is_exported( false );
+    std::atomic<bool>   is_imported( false );
+    uint32_t            num_sent        = 0;
+    uint32_t            num_imported    = 0;
+
+    std::thread sender( [&]()
+            {
+                try
+                {
+                    num_sent = session_manager::export_sessions( m1, fds_out[0] );
+                }
+                catch( std::exception & e )
+                {
+                    std::cout << "ERROR: " << e.what() << std::endl;
+                }
+
+                close( fds_out[0] );
+
+                is_exported = true;
+            } );
+
+    std::thread receiver( [&]()
+            {
+                try
+                {
+                    num_imported = session_manager::import_sessions( m2, fds_in[1] );
+                }
+                catch( std::exception & e )
+                {
+                    std::cout << "ERROR: " << e.what() << std::endl;
+                }
+
+                is_imported = true;
+            } );
+
+    // returns the sessions of the chunks imported so far, they are behind the cursor of the export
+    auto get_imported = [&]( std::size_t max_count )
+            {
+                std::vector<std::string> ids;
+
+                session_manager::SessionManager::SessionInfo info;
+
+                for( auto & r : records )
+                {
+                    if( ids.size() == max_count )
+                        break;
+
+                    if( m2.get_session_info( & info, r.session_id ) )
+                        ids.push_back( r.session_id );
+                }
+
+                return ids;
+            };
+
+    // forwards the stream and stops once the first chunk was imported, so that the sender blocks
+    // on the full socket before it reaches the end of the walk
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    is_paused   = false;
+    bool                    is_resumed  = false;
+
+    std::thread relay( [&]()
+            {
+                char buf[4096];
+
+                while( true )
+                {
+                    auto size = recv( fds_out[1], buf, sizeof( buf ), 0 );
+
+                    if( size <= 0 )
+                        break;
+
+                    for( ssize_t sent = 0; sent < size; )
+                    {
+                        auto res = send( fds_in[0], buf + sent, size - sent, MSG_NOSIGNAL );
+
+                        if( res <= 0 )
+                            break;
+
+                        sent += res;
+                    }
+
+                    if( is_resumed )
+                        continue;
+
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+                    if( get_imported( 1 ).empty() )
+                        continue;
+
+                    std::unique_lock<std::mutex> lock( mutex );
+
+                    is_paused = true;
+
+                    cond.notify_all();
+
+                    cond.wait( lock, [&]() { return is_resumed; } );
+                }
+
+                close( fds_in[0] );
+
+                std::lock_guard<std::mutex> lock( mutex );
+
+                is_paused = true;
+
+                cond.notify_all();
+            } );
+
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+
+        cond.wait( lock, [&]() { return is_paused; } );
+    }
+
+    if( is_exported || is_imported )
+        std::cout << "ERROR: handoff finished before the test could act" << std::endl;
+
+    auto ids = get_imported( 3 );
+
+    ids.resize( 3 );
+
+    if( m2.is_authenticated( ids[1] ) && is_imported == false )
+        std::cout << "OK: session validated by the new manager while later chunks are still arriving" << std::endl;
+    else
+        std::cout << "ERROR: session NOT validated by the new manager during the handoff" << std::endl;
+
+    // changes behind the cursor: a close, an update of attributes, a postponement and a login
+    std::string error;
+    std::string new_id;
+
+    m1.close_session( ids[0], error );
+
+    m1.set_attributes( ids[1], "role=admin", error );
+
+    clock.advance( std::chrono::minutes( 1 ) );
+
+    m1.is_authenticated( ids[2] );
+
+    auto postponed = std::chrono::system_clock::to_time_t( clock.get_now() + std::chrono::minutes( c.expiration_time_min ) );
+
+    m1.authenticate( user_id, password, new_id, error );
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+
+        is_resumed = true;
+
+        cond.notify_all();
+    }
+
+    sender.join();
+    relay.join();
+    receiver.join();
+
+    close( fds_out[1] );
+    close( fds_in[1] );
+
+    std::cout << "sent " << num_sent << " sessions, imported " << num_imported << std::endl;
+
+    session_manager::SessionManager::SessionInfo info;
+
+    if( m2.is_authenticated( ids[0] ) == false )
+        std::cout << "OK: session closed during the handoff is closed in the new manager" << std::endl;
+    else
+        std::cout << "ERROR: session closed during the handoff is alive in the new manager" << std::endl;
+
+    if( m2.get_session_info( & info, ids[1] ) && info.attributes == "role=admin" )
+        std::cout << "OK: attributes set during the handoff were transferred" << std::endl;
+    else
+        std::cout << "ERROR: attributes set during the handoff were lost" << std::endl;
+
+    if( m2.get_session_info( & info, ids[2] ) && std::chrono::system_clock::to_time_t( info.expiration_time ) == postponed )
+        std::cout << "OK: postponement during the handoff was transferred" << std::endl;
+    else
+        std::cout << "ERROR: postponement during the handoff was lost" << std::endl;
+
+    session_manager::user_id_t user_id_2;
+
+    if( m2.get_user_id( & user_id_2, new_id ) && user_id_2 == user_id )
+        std::cout << "OK: login during the handoff was transferred" << std::endl;
+    else
+        std::cout << "ERROR: login during the handoff was lost" << std::endl;
+
+    if( m1.authenticate( user_id, password, new_id, error ) == false )
+        std::cout << "OK: old manager rejects logins after the handoff: " << error << std::endl;
+    else
+        std::cout << "ERROR: old manager accepted a login after the handoff" << std::endl;
+}
+
+bool login( session_manager::SessionManager & m, uint32_t user_id, const std::string & password, std::string * id )
+{
+    std::string error;
+
+    auto b = m.authenticate( user_id, password, * id, error );
+
+    if( b == false )
+        std::cout << "login of user " << user_id << " failed: " << error << std::endl;
+
+    return b;
+}
+
+void test_capacity( session_manager::IAuthenticator * auth, const session_manager::Config & cfg, session_manager::ManualClock & clock )
+{
+    std::cout << "testing: global capacity, reject on overflow" << std::endl;
+
+    {
+        session_manager::Config c = cfg;
+
+        c.max_sessions      = 2;
+        c.evict_on_overflow = false;
+
+        session_manager::SessionManager m;
+
+        m.init( auth, c, & clock );
+
+        std::string id1, id2, id3;
+
+        login( m, 1, "alpha", & id1 );
+        login( m, 2, "beta", & id2 );
+
+        if( login( m, 3, "gamma", & id3 ) )
+            std::cout << "ERROR: login above the capacity was accepted" << std::endl;
+        else
+            std::cout << "OK: login above the capacity was rejected, usage " << m.get_capacity_usage() << std::endl;
+
+        clock.advance( std::chrono::minutes( cfg.expiration_time_min ) );
+
+        if( login( m, 3, "gamma", & id3 ) )
+            std::cout << "OK: login accepted after the sessions expired, usage " << m.get_capacity_usage() << std::endl;
+        else
+            std::cout << "ERROR: login rejected although the sessions expired" << std::endl;
+    }
+
+    std::cout << "testing: global capacity, evict on overflow" << std::endl;
+
+    {
+        session_manager::Config c = cfg;
+
+        c.max_sessions      = 3;
+        c.evict_on_overflow = true;
+
+        session_manager::SessionManager m;
+
+        m.init( auth, c, & clock );
+
+        std::string id1, id2, id3, id4, id5;
+
+        // distinct expiration times, user 1 is the closest to expiry
+        login( m, 1, "alpha", & id1 );
+        clock.advance( std::chrono::seconds( 10 ) );
+        login( m, 2, "beta", & id2 );
+        clock.advance( std::chrono::seconds( 10 ) );
+        login( m, 3, "gamma", & id3 );
+
+        if( login( m, 3, "gamma", & id4 ) && m.is_authenticated( id1 ) == false && m.is_authenticated( id2 ) )
+            std::cout << "OK: session closest to expiry was evicted" << std::endl;
+        else
+            std::cout << "ERROR: wrong session was evicted" << std::endl;
+
+        // user 3 is at max_sessions_per_user, the rejected login must not evict user 2
+        if( login( m, 3, "gamma", & id5 ) == false && m.is_authenticated( id2 ) )
+            std::cout << "OK: rejected login did not evict other sessions" << std::endl;
+        else
+            std::cout << "ERROR: rejected login evicted other sessions" << std::endl;
+    }
+}
+
+void test_authenticate_async( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
+{
+    std::cout << "testing: asynchronous authentication" << std::endl;
+
+    QueueExecutor executor;
+
+    bool        is_done     = false;
+    bool        is_ok       = false;
+    std::string id;
+
+    m.authenticate_async( & executor, user_id, password, [&]( bool res, const std::string & session_id, const std::string & error )
+            {
+                is_done = true;
+                is_ok   = res;
+                id      = session_id;
+
+                if( res == false )
+                    std::cout << "ERROR: " << error << std::endl;
+            } );
+
+    if( is_done )
+        std::cout << "ERROR: authentication was completed on the calling thread" << std::endl;
+    else
+        std::cout << "OK: authentication was posted to the executor" << std::endl;
+
+    executor.run();
+
+    if( is_done && is_ok && m.is_authenticated( id ) )
+        std::cout << "OK: session created on the executor was validated: session id = " << id << std::endl;
+    else
+        std::cout << "ERROR: asynchronous authentication failed" << std::endl;
+
+    std::string error;
+
+    m.close_session( id, error );
+
+    is_done = false;
+
+    m.authenticate_async( & executor, user_id, "wrong", [&]( bool res, const std::string &, const std::string & error )
+            {
+                is_done = true;
+                is_ok   = res;
+
+                if( res == false )
+                    std::cout << "OK: wrong password was rejected on the executor: " << error << std::endl;
+            } );
+
+    executor.run();
+
+    if( is_done == false || is_ok )
+        std::cout << "ERROR: wrong password was not rejected" << std::endl;
+}
+
+#if defined( __cpp_impl_coroutine )
+
+// coroutine which starts at once and is awaited by nobody, enough to drive an awaitable in a test
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object() { return DetachedCoroutine(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// parameters are taken by value, as the coroutine outlives the call
+DetachedCoroutine login_co( session_manager::SessionManager & m, session_manager::IExecutor * executor, uint32_t user_id, std::string password,
+        session_manager::SessionManager::AuthResult * result, bool * is_done )
+{
+    * result = co_await session_manager::authenticate_co( m, executor, user_id, password );
+
+    * is_done = true;
+}
+
+void test_authenticate_co( session_manager::SessionManager & m, uint32_t user_id, const std::string & password )
+{
+    std::cout << "testing: coroutine authentication" << std::endl;
+
+    QueueExecutor executor;
+
+    session_manager::SessionManager::AuthResult result;
+
+    bool is_done = false;
+
+    login_co( m, & executor, user_id, password, & result, & is_done );
+
+    if( is_done )
+        std::cout << "ERROR: coroutine was not suspended" << std::endl;
+    else
+        std::cout << "OK: coroutine was suspended until the executor ran" << std::endl;
+
+    executor.run();
+
+    if( is_done && result.is_ok && m.is_authenticated( result.session_id ) )
+        std::cout << "OK: coroutine was resumed with a valid session: session id = " << result.session_id << std::endl;
+    else
+        std::cout << "ERROR: coroutine authentication failed" << std::endl;
+
+    std::string error;
+
+    m.close_session( result.session_id, error );
+
+    is_done = false;
+
+    login_co( m, & executor, user_id, "wrong", & result, & is_done );
+
+    executor.run();
+
+    if( is_done && result.is_ok == false )
+        std::cout << "OK: coroutine was resumed with the rejection of a wrong password: " << result.error << std::endl;
+    else
+        std::cout << "ERROR: wrong password was not rejected" << std::endl;
+}
+
+#endif // __cpp_impl_coroutine
+
+void test_serialized_authenticator( const session_manager::Config & cfg, session_manager::IClock * clock )
+{
+    std::cout << "testing: authenticator which is not thread-safe" << std::endl;
+
+    SlowAuthenticator auth;
+
+    session_manager::SessionManager m;
+
+    m.init( & auth, cfg, clock );
+
+    std::vector<std::thread> threads;
+
+    for( uint32_t i = 0; i < 4; ++i )
+    {
+        threads.push_back( std::thread( [&m, i]()
+                {
+                    for( uint32_t j = 0; j < 5; ++j )
+                    {
+                        std::string id;
+                        std::string error;
+
+                        m.authenticate( 100 + i * 5 + j, "", id, error );
+                    }
+                } ) );
+    }
+
+    for( auto & t : threads )
+        t.join();
+
+    if( auth.get_max_active() == 1 )
+        std::cout << "OK: calls of the authenticator were serialized" << std::endl;
+    else
+        std::cout << "ERROR: authenticator was called concurrently: " << auth.get_max_active() << " calls" << std::endl;
+}
+
 int main()
 {
     try
@@ -403,9 +1170,17 @@ int main()
 
         Authenticator a;
 
+        session_manager::ManualClock clock( std::chrono::system_clock::now() );
+
         session_manager::SessionManager m;
 
-        m.init( & a, cfg );
+        m.init( & a, cfg, & clock );
+
+        session_manager::Config cfg_tenant = cfg;
+
+        cfg_tenant.max_sessions_per_user    = 1;
+
+        m.add_namespace( 1, cfg_tenant );
 
         const uint32_t user1 = 1;
         const uint32_t user2 = 2;
@@ -425,13 +1200,33 @@ int main()
 
         test_close_wrong_id( m );
 
-        test_expiration( m, user2, "beta", cfg.expiration_time_min );
+        test_parse_session_id();
+
+        test_expiration( m, clock, user2, "beta", cfg.expiration_time_min );
 
-        test_remove_expired( m, user4, "omega", cfg.expiration_time_min );
+        test_remove_expired( m, clock, user4, "omega", cfg.expiration_time_min );
 
         test_get_session_info( m, user4, "omega" );
         test_get_session_info_2( m, user4, "omega" );
 
+        test_get_sessions( m, user4, "omega" );
+
+        test_namespaces( m, user1, "alpha" );
+
+        test_authenticate_batch( m );
+
+        test_handoff( & a, cfg, user1, "alpha" );
+
+        test_capacity( & a, cfg, clock );
+
+        test_authenticate_async( m, user1, "alpha" );
+
+#if defined( __cpp_impl_coroutine )
+        test_authenticate_co( m, user1, "alpha" );
+#endif
+
+        test_serialized_authenticator( cfg, & clock );
+
         return 0;
     }
     catch( std::exception & e )
@@ -0,0 +1,77 @@
+/*
+
+Authenticator interface.
+
+Copyright (C) 2016 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "i_authenticator.h"    // self
+
+#include <future>               // std::async
+#include <thread>               // std::thread::hardware_concurrency
+#include <algorithm>            // std::min
+
+#define MIN_CHUNK_SIZE      64      // smaller batches are not worth starting a thread
+
+namespace session_manager
+{
+
+void IAuthenticator::is_authenticated_batch( std::vector<uint8_t> * res, const std::vector<Credentials> & credentials ) const
+{
+    res->assign( credentials.size(), 0 );
+
+    std::size_t num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+    std::size_t chunk_size  = std::max( std::size_t( MIN_CHUNK_SIZE ), ( credentials.size() + num_threads - 1 ) / num_threads );
+
+    if( is_thread_safe() == false || credentials.size() <= chunk_size )
+    {
+        for( std::size_t i = 0; i < credentials.size(); ++i )
+        {
+            ( * res )[i] = is_authenticated( credentials[i].user_id, credentials[i].password ) ? 1 : 0;
+        }
+
+        return;
+    }
+
+    std::vector<std::future<void>>  futures;
+
+    // the first chunk is checked by the calling thread
+    for( std::size_t begin = chunk_size; begin < credentials.size(); begin += chunk_size )
+    {
+        auto end = std::min( begin + chunk_size, credentials.size() );
+
+        futures.push_back( std::async( std::launch::async, [this, res, & credentials, begin, end]()
+                {
+                    for( auto i = begin; i < end; ++i )
+                    {
+                        ( * res )[i] = is_authenticated( credentials[i].user_id, credentials[i].password ) ? 1 : 0;
+                    }
+                } ) );
+    }
+
+    for( std::size_t i = 0; i < chunk_size; ++i )
+    {
+        ( * res )[i] = is_authenticated( credentials[i].user_id, credentials[i].password ) ? 1 : 0;
+    }
+
+    for( auto & f : futures )
+        f.get();
+}
+
+} // namespace session_manager
@@ -21,7 +21,9 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 // $Revision: 3630 $ $Date:: 2016-04-05 #$ $Author: serge $
 
+#include <cstdint>      // uint32_t
 #include <string>       // std::string
+#include <vector>       // std::vector
 
 #ifndef SESSION_MANAGER_I_AUTHENTICATOR_H
 #define SESSION_MANAGER_I_AUTHENTICATOR_H
@@ -29,12 +31,31 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 namespace session_manager
 {
 
+struct Credentials
+{
+    uint32_t        user_id;
+    std::string     password;
+};
+
+// NOTE: is_authenticated() is called by SessionManager without holding its lock; the calls are serialized
+// by SessionManager unless is_thread_safe() returns true
 class IAuthenticator
 {
 public:
     virtual ~IAuthenticator() {}
 
     virtual bool is_authenticated( uint32_t user_id, const std::string & password ) const    = 0;
+
+    // true if is_authenticated() can be called concurrently from several threads
+    virtual bool is_thread_safe() const
+    {
+        return false;
+    }
+
+    // checks a batch of credentials, res[i] is set to 1 if credentials[i] are valid;
+    // the default implementation calls is_authenticated() in parallel if it is thread-safe and the batch
+    // is larger than one chunk, authenticators with a native batch lookup should override it
+    virtual void is_authenticated_batch( std::vector<uint8_t> * res, const std::vector<Credentials> & credentials ) const;
 };
 
 }
@@ -0,0 +1,43 @@
+/*
+
+Clock interface.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include <chrono>       // std::chrono::system_clock::time_point
+
+#ifndef SESSION_MANAGER_I_CLOCK_H
+#define SESSION_MANAGER_I_CLOCK_H
+
+namespace session_manager
+{
+
+// NOTE: get_now() is called concurrently from several threads and must be thread-safe
+class IClock
+{
+public:
+    virtual ~IClock() {}
+
+    virtual std::chrono::system_clock::time_point get_now() const   = 0;
+};
+
+}
+
+#endif // SESSION_MANAGER_I_CLOCK_H
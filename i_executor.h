@@ -0,0 +1,45 @@
+/*
+
+Executor interface.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include <functional>   // std::function
+
+#ifndef SESSION_MANAGER_I_EXECUTOR_H
+#define SESSION_MANAGER_I_EXECUTOR_H
+
+namespace session_manager
+{
+
+// runs tasks which may block, e.g. a thread pool or a thread owned by a shard of an event loop;
+// NOTE: post() is called concurrently from several threads and must be thread-safe
+class IExecutor
+{
+public:
+    virtual ~IExecutor() {}
+
+    virtual void post( const std::function<void()> & task )   = 0;
+};
+
+}
+
+#endif // SESSION_MANAGER_I_EXECUTOR_H
@@ -33,6 +33,13 @@ void init_config( Config * cfg, const std::string & section_name, const config_r
     GET_VALUE_CONVERTED( cr, cfg, expiration_time_min, section_name, true );
     GET_VALUE_CONVERTED( cr, cfg, max_sessions_per_user, section_name, true );
     GET_VALUE_CONVERTED( cr, cfg, postpone_expiration, section_name, true );
+    GET_VALUE_CONVERTED( cr, cfg, use_thread_cache, section_name, false );
+    GET_VALUE_CONVERTED( cr, cfg, max_sessions, section_name, false );
+    GET_VALUE_CONVERTED( cr, cfg, max_memory_kb, section_name, false );
+    GET_VALUE_CONVERTED( cr, cfg, evict_on_overflow, section_name, false );
+    GET_VALUE_CONVERTED( cr, cfg, filter_size, section_name, false );
+    GET_VALUE( cr, cfg, stats_file, section_name, false );
+    GET_VALUE_CONVERTED( cr, cfg, stats_interval_sec, section_name, false );
 }
 
 } // namespace session_manager
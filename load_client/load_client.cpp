@@ -0,0 +1,328 @@
+/*
+
+Session daemon load client.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+// Benchmarks the session daemon: every connection logs in one user and then sends validations
+// of its session in pipelined rounds of <pipeline_depth> requests until the time is over.
+// Connection i uses user <first_user_id> + i.
+
+#include "session_manager/daemon/protocol.h"    // session_manager::protocol
+
+#include <iostream>             // std::cout
+#include <algorithm>            // std::sort
+#include <atomic>               // std::atomic
+#include <chrono>               // std::chrono
+#include <mutex>                // std::mutex
+#include <thread>               // std::thread
+#include <vector>               // std::vector
+#include <stdexcept>            // std::runtime_error
+#include <cstring>              // memset
+#include <cerrno>               // errno
+#include <unistd.h>             // close
+#include <sys/socket.h>         // socket
+#include <sys/un.h>             // sockaddr_un
+#include <netinet/in.h>         // sockaddr_in
+#include <netinet/tcp.h>        // TCP_NODELAY
+#include <arpa/inet.h>          // inet_pton
+
+namespace protocol = session_manager::protocol;
+
+struct Params
+{
+    std::string     address;
+    uint32_t        num_connections;
+    uint32_t        pipeline_depth;
+    uint32_t        duration_sec;
+    uint32_t        first_user_id;
+    std::string     password;
+};
+
+struct Result
+{
+    uint64_t                num_requests;
+    uint64_t                num_failed;
+    std::vector<uint64_t>   round_latencies_ns;
+};
+
+int connect_to( const std::string & address )
+{
+    auto pos = address.rfind( ':' );
+
+    bool is_tcp = ( pos != std::string::npos && address.find( '/' ) == std::string::npos );
+
+    int fd = socket( is_tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0 );
+
+    if( fd < 0 )
+        throw std::runtime_error( "cannot create socket, errno " + std::to_string( errno ) );
+
+    int res;
+
+    if( is_tcp )
+    {
+        sockaddr_in addr;
+
+        memset( & addr, 0, sizeof( addr ) );
+
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons( std::stoul( address.substr( pos + 1 ) ) );
+
+        inet_pton( AF_INET, address.substr( 0, pos ).c_str(), & addr.sin_addr );
+
+        res = connect( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) );
+
+        int on = 1;
+
+        setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, & on, sizeof( on ) );
+    }
+    else
+    {
+        sockaddr_un addr;
+
+        memset( & addr, 0, sizeof( addr ) );
+
+        addr.sun_family = AF_UNIX;
+
+        address.copy( addr.sun_path, sizeof( addr.sun_path ) - 1 );
+
+        res = connect( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) );
+    }
+
+    if( res != 0 )
+    {
+        close( fd );
+        throw std::runtime_error( "cannot connect to " + address + ", errno " + std::to_string( errno ) );
+    }
+
+    return fd;
+}
+
+void send_all( int fd, const std::string & data )
+{
+    std::size_t offset = 0;
+
+    while( offset < data.size() )
+    {
+        auto res = send( fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL );
+
+        if( res <= 0 )
+            throw std::runtime_error( "send failed, errno " + std::to_string( errno ) );
+
+        offset += res;
+    }
+}
+
+// reads one response, returns its status, the payload is stored in payload
+protocol::status_e read_response( int fd, std::string * buffer, std::string * payload )
+{
+    while( true )
+    {
+        if( buffer->size() >= protocol::HEADER_SIZE )
+        {
+            auto size = protocol::read_uint32( buffer->data() );
+
+            if( size == 0 || size > protocol::MAX_BODY_SIZE )
+                throw std::runtime_error( "malformed response" );
+
+            if( buffer->size() >= protocol::HEADER_SIZE + size )
+            {
+                auto status = static_cast<protocol::status_e>( ( * buffer )[ protocol::HEADER_SIZE ] );
+
+                payload->assign( * buffer, protocol::HEADER_SIZE + 1, size - 1 );
+
+                buffer->erase( 0, protocol::HEADER_SIZE + size );
+
+                return status;
+            }
+        }
+
+        char data[ 65536 ];
+
+        auto res = recv( fd, data, sizeof( data ), 0 );
+
+        if( res <= 0 )
+            throw std::runtime_error( "connection closed by the daemon" );
+
+        buffer->append( data, res );
+    }
+}
+
+void run_connection( Result * result, const Params & params, uint32_t user_id, const std::chrono::steady_clock::time_point & end_time )
+{
+    int fd = connect_to( params.address );
+
+    std::string buffer;
+    std::string payload;
+    std::string request;
+
+    // log in
+
+    std::string credentials;
+
+    protocol::append_uint32( & credentials, user_id );
+
+    credentials += params.password;
+
+    protocol::append_request( & request, protocol::AUTHENTICATE, 0, credentials );
+
+    send_all( fd, request );
+
+    std::string session_id;
+
+    if( read_response( fd, & buffer, & session_id ) != protocol::OK )
+    {
+        close( fd );
+        throw std::runtime_error( "user " + std::to_string( user_id ) + " NOT authenticated: " + session_id );
+    }
+
+    // one round of pipelined validations is prepared once and sent repeatedly
+
+    request.clear();
+
+    for( uint32_t i = 0; i < params.pipeline_depth; ++i )
+        protocol::append_request( & request, protocol::VALIDATE, 0, session_id );
+
+    while( std::chrono::steady_clock::now() < end_time )
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        send_all( fd, request );
+
+        for( uint32_t i = 0; i < params.pipeline_depth; ++i )
+        {
+            if( read_response( fd, & buffer, & payload ) != protocol::OK )
+                ++result->num_failed;
+        }
+
+        result->round_latencies_ns.push_back( ( std::chrono::steady_clock::now() - begin ).count() );
+
+        result->num_requests += params.pipeline_depth;
+    }
+
+    // log out
+
+    request.clear();
+
+    protocol::append_request( & request, protocol::CLOSE, 0, session_id );
+
+    send_all( fd, request );
+
+    read_response( fd, & buffer, & payload );
+
+    close( fd );
+}
+
+uint64_t get_percentile( const std::vector<uint64_t> & sorted, double p )
+{
+    return sorted[ static_cast<std::size_t>( p / 100.0 * ( sorted.size() - 1 ) ) ];
+}
+
+int main( int argc, char ** argv )
+{
+    if( argc != 5 && argc != 7 )
+    {
+        std::cout << "USAGE: load_client <socket_path | 127.0.0.1:port> <num_connections> <pipeline_depth> <duration_sec> [<first_user_id> <password>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        Params params;
+
+        params.address          = argv[1];
+        params.num_connections  = std::stoul( argv[2] );
+        params.pipeline_depth   = std::stoul( argv[3] );
+        params.duration_sec     = std::stoul( argv[4] );
+        params.first_user_id    = ( argc == 7 ) ? std::stoul( argv[5] ) : 1;
+        params.password         = ( argc == 7 ) ? argv[6] : "";
+
+        if( params.num_connections == 0 || params.pipeline_depth == 0 )
+            throw std::invalid_argument( "num_connections and pipeline_depth must not be 0" );
+
+        std::vector<Result>         results( params.num_connections, Result() );
+        std::vector<std::thread>    threads;
+
+        std::mutex      error_mutex;
+        std::string     error;
+
+        auto begin      = std::chrono::steady_clock::now();
+        auto end_time   = begin + std::chrono::seconds( params.duration_sec );
+
+        for( uint32_t i = 0; i < params.num_connections; ++i )
+        {
+            threads.push_back( std::thread( [&, i]()
+                {
+                    try
+                    {
+                        run_connection( & results[i], params, params.first_user_id + i, end_time );
+                    }
+                    catch( std::exception & e )
+                    {
+                        std::lock_guard<std::mutex> lock( error_mutex );
+
+                        error = e.what();
+                    }
+                } ) );
+        }
+
+        for( auto & t : threads )
+            t.join();
+
+        if( error.empty() == false )
+            throw std::runtime_error( error );
+
+        double elapsed_sec = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+        uint64_t num_requests   = 0;
+        uint64_t num_failed     = 0;
+
+        std::vector<uint64_t> latencies;
+
+        for( auto & r : results )
+        {
+            num_requests    += r.num_requests;
+            num_failed      += r.num_failed;
+
+            latencies.insert( latencies.end(), r.round_latencies_ns.begin(), r.round_latencies_ns.end() );
+        }
+
+        std::cout << "validations: " << num_requests << ", failed " << num_failed
+                << ", " << static_cast<uint64_t>( num_requests / elapsed_sec ) << " per second" << std::endl;
+
+        if( latencies.empty() == false )
+        {
+            std::sort( latencies.begin(), latencies.end() );
+
+            std::cout << "round of " << params.pipeline_depth << " requests: p50 " << get_percentile( latencies, 50.0 ) << " ns"
+                    << ", p99 " << get_percentile( latencies, 99.0 ) << " ns"
+                    << ", max " << latencies.back() << " ns" << std::endl;
+        }
+
+        return 0;
+    }
+    catch( std::exception & e )
+    {
+        std::cout << "ERROR: " << e.what() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+}
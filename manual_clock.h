@@ -0,0 +1,65 @@
+/*
+
+Manual Clock.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER_MANUAL_CLOCK_H
+#define SESSION_MANAGER_MANUAL_CLOCK_H
+
+#include <atomic>       // std::atomic
+
+#include "i_clock.h"    // IClock
+
+namespace session_manager
+{
+
+// clock which is moved forward explicitly, for tests and trace replay
+class ManualClock: public IClock
+{
+public:
+    ManualClock( const std::chrono::system_clock::time_point & now ):
+        now_( now.time_since_epoch().count() )
+    {
+    }
+
+    void set_now( const std::chrono::system_clock::time_point & now )
+    {
+        now_.store( now.time_since_epoch().count(), std::memory_order_relaxed );
+    }
+
+    void advance( const std::chrono::system_clock::duration & d )
+    {
+        now_.fetch_add( d.count(), std::memory_order_relaxed );
+    }
+
+    // interface IClock
+    virtual std::chrono::system_clock::time_point get_now() const
+    {
+        return std::chrono::system_clock::time_point( std::chrono::system_clock::duration( now_.load( std::memory_order_relaxed ) ) );
+    }
+
+private:
+    std::atomic<std::chrono::system_clock::rep>     now_;
+};
+
+}
+
+#endif // SESSION_MANAGER_MANUAL_CLOCK_H
@@ -0,0 +1,122 @@
+/*
+
+Session Manager - Record Arena.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "record_arena.h"       // self
+
+#include <cassert>              // assert
+#include <cstring>              // memcpy
+#include <new>                  // std::bad_alloc
+
+#define CHUNK_BITS      18                                  // 2 MB chunks
+#define CHUNK_UNITS     ( uint32_t( 1 ) << CHUNK_BITS )
+#define MAX_CHUNKS      ( ( RecordArena::MAX_INDEX >> CHUNK_BITS ) + 1 )
+
+namespace session_manager
+{
+
+const uint32_t RecordArena::UNIT_SIZE;
+const uint32_t RecordArena::NULL_INDEX;
+const uint32_t RecordArena::MAX_INDEX;
+
+RecordArena::RecordArena():
+        chunks_( new std::atomic<char*>[ MAX_CHUNKS ]() ),
+        num_chunks_( 0 ),
+        next_index_( NULL_INDEX + 1 )
+{
+}
+
+RecordArena::~RecordArena()
+{
+    for( uint32_t i = 0; i < num_chunks_; ++i )
+        delete[] chunks_[i].load( std::memory_order_relaxed );
+}
+
+uint32_t RecordArena::get_num_units( std::size_t size )
+{
+    return static_cast<uint32_t>( ( size + UNIT_SIZE - 1 ) / UNIT_SIZE );
+}
+
+uint32_t RecordArena::allocate( uint32_t num_units )
+{
+    assert( num_units > 0 && num_units <= CHUNK_UNITS );
+
+    if( num_units < free_lists_.size() && free_lists_[ num_units ] != NULL_INDEX )
+    {
+        auto res = free_lists_[ num_units ];
+
+        memcpy( & free_lists_[ num_units ], get( res ), sizeof( uint32_t ) );
+
+        return res;
+    }
+
+    // a block never crosses the end of a chunk, the rest of the chunk is kept as a free block
+    auto offset = next_index_ & ( CHUNK_UNITS - 1 );
+
+    if( offset != 0 && offset + num_units > CHUNK_UNITS )
+    {
+        free( next_index_, CHUNK_UNITS - offset );
+
+        next_index_ += CHUNK_UNITS - offset;
+    }
+
+    auto end = uint64_t( next_index_ ) + num_units;
+
+    if( end > uint64_t( MAX_INDEX ) + 1 )
+        throw std::bad_alloc();
+
+    while( ( uint64_t( num_chunks_ ) << CHUNK_BITS ) < end )
+    {
+        chunks_[ num_chunks_ ].store( new char[ CHUNK_UNITS * UNIT_SIZE ], std::memory_order_release );
+
+        ++num_chunks_;
+    }
+
+    auto res = next_index_;
+
+    next_index_ += num_units;
+
+    return res;
+}
+
+void RecordArena::free( uint32_t index, uint32_t num_units )
+{
+    if( free_lists_.size() <= num_units )
+        free_lists_.resize( num_units + 1, NULL_INDEX );
+
+    memcpy( get( index ), & free_lists_[ num_units ], sizeof( uint32_t ) );
+
+    free_lists_[ num_units ] = index;
+}
+
+void * RecordArena::get( uint32_t index ) const
+{
+    return chunks_[ index >> CHUNK_BITS ].load( std::memory_order_acquire ) + std::size_t( index & ( CHUNK_UNITS - 1 ) ) * UNIT_SIZE;
+}
+
+std::size_t RecordArena::get_memory() const
+{
+    return std::size_t( num_chunks_ ) * CHUNK_UNITS * UNIT_SIZE;
+}
+
+} // namespace session_manager
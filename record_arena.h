@@ -0,0 +1,76 @@
+/*
+
+Session Manager - Record Arena.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__RECORD_ARENA_H
+#define SESSION_MANAGER__RECORD_ARENA_H
+
+#include <atomic>       // std::atomic
+#include <memory>       // std::unique_ptr
+#include <vector>       // std::vector
+#include <cstdint>      // uint32_t
+
+namespace session_manager
+{
+
+// memory of the session records, in units of 8 bytes addressed by a 32-bit index, so that a link between records
+// takes 4 bytes instead of 8 and a record has no allocator header; freed blocks are reused by blocks of the same size.
+//
+// get() is lock-free: chunks never move and are published before any index pointing into them.
+// allocate() and free() must be serialized by the caller.
+class RecordArena
+{
+public:
+
+    static const uint32_t UNIT_SIZE     = 8;
+    static const uint32_t NULL_INDEX    = 0;        // never allocated
+    static const uint32_t MAX_INDEX     = 0x7FFFFFFF;
+
+    RecordArena();
+    ~RecordArena();
+
+    RecordArena( const RecordArena & )              = delete;
+    RecordArena & operator=( const RecordArena & )  = delete;
+
+    static uint32_t get_num_units( std::size_t size );
+
+    // index of a block of the given number of units, throws std::bad_alloc if the arena is full
+    uint32_t allocate( uint32_t num_units );
+
+    void free( uint32_t index, uint32_t num_units );
+
+    void * get( uint32_t index ) const;
+
+    // memory of the allocated chunks, in bytes
+    std::size_t get_memory() const;
+
+private:
+    std::unique_ptr<std::atomic<char*>[]>   chunks_;
+    uint32_t                num_chunks_;
+    uint32_t                next_index_;        // first unit which was never allocated
+    std::vector<uint32_t>   free_lists_;        // number of units -> first free block, linked by their first 4 bytes
+};
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__RECORD_ARENA_H
@@ -0,0 +1,470 @@
+/*
+
+Session trace replay.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+// Feeds a trace of login/validate/close events through SessionManager at full speed.
+// The time of the manager is driven by the event timestamps, so hours of traffic are replayed in seconds.
+//
+// Trace format, one event per line:
+//
+//   <time_ms> <login|validate|close> <user_id>
+//
+// validate uses the latest session of the user, close closes the oldest one.
+//
+// After the replay, the memory per session is measured on a separate manager filled with
+// MEMORY_PROBE_SESSIONS sessions: the estimate of the manager and the real growth of RSS are printed.
+
+#include "session_manager/session_manager.h"    // session_manager::SessionManager
+#include "session_manager/i_authenticator.h"    // session_manager::IAuthenticator
+#include "session_manager/init_config.h"        // session_manager::init_config
+#include "session_manager/manual_clock.h"       // session_manager::ManualClock
+#include "config_reader/config_reader.h"        // config_reader::ConfigReader
+
+#include <iostream>             // std::cout
+#include <fstream>              // std::ifstream
+#include <sstream>              // std::istringstream
+#include <algorithm>            // std::max
+#include <iterator>             // std::begin
+#include <random>               // std::mt19937
+#include <deque>                // std::deque
+#include <map>                  // std::map
+#include <stdexcept>            // std::runtime_error
+#include <unistd.h>             // sysconf
+
+#define MEMORY_PROBE_SESSIONS   1000000
+
+class Authenticator: public session_manager::IAuthenticator
+{
+public:
+
+    // interface session_manager::IAuthenticator
+    virtual bool is_authenticated( uint32_t user_id, const std::string & password ) const
+    {
+        return true;
+    }
+};
+
+enum class op_e
+{
+    LOGIN,
+    VALIDATE,
+    CLOSE,
+};
+
+struct Event
+{
+    uint64_t    time_ms;
+    op_e        op;
+    uint32_t    user_id;
+};
+
+class IEventSource
+{
+public:
+    virtual ~IEventSource() {}
+
+    virtual bool get_next( Event * ev ) = 0;
+};
+
+class TraceReader: public IEventSource
+{
+public:
+    TraceReader( const std::string & filename ):
+        in_( filename ),
+        line_num_( 0 )
+    {
+        if( in_.is_open() == false )
+            throw std::runtime_error( "cannot open trace file " + filename );
+    }
+
+    // interface IEventSource
+    virtual bool get_next( Event * ev )
+    {
+        std::string line;
+
+        while( std::getline( in_, line ) )
+        {
+            ++line_num_;
+
+            if( line.empty() || line[0] == '#' )
+                continue;
+
+            std::istringstream is( line );
+
+            std::string op;
+
+            if( !( is >> ev->time_ms >> op >> ev->user_id ) )
+                throw std::runtime_error( "malformed trace line " + std::to_string( line_num_ ) );
+
+            if( op == "login" )
+                ev->op = op_e::LOGIN;
+            else if( op == "validate" )
+                ev->op = op_e::VALIDATE;
+            else if( op == "close" )
+                ev->op = op_e::CLOSE;
+            else
+                throw std::runtime_error( "unknown operation " + op + " in line " + std::to_string( line_num_ ) );
+
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::ifstream   in_;
+    uint32_t        line_num_;
+};
+
+// synthetic trace: uniform event rate, 10% logins, 85% validations, 5% closes
+class TraceGenerator: public IEventSource
+{
+public:
+    TraceGenerator( uint32_t hours, uint32_t num_users, uint32_t events_per_sec ):
+        end_time_ms_( uint64_t( hours ) * 3600 * 1000 ),
+        num_users_( num_users ),
+        step_ns_( 0 ),
+        time_ns_( 0 ),
+        rng_( 42 )
+    {
+        if( num_users == 0 )
+            throw std::invalid_argument( "num_users must not be 0" );
+
+        if( events_per_sec == 0 || events_per_sec > 1000000000 )
+            throw std::invalid_argument( "events_per_sec must be in range 1 - 1000000000" );
+
+        step_ns_ = 1000000000 / events_per_sec;
+    }
+
+    // interface IEventSource
+    virtual bool get_next( Event * ev )
+    {
+        if( time_ns_ / 1000000 >= end_time_ms_ )
+            return false;
+
+        auto r = rng_() % 100;
+
+        ev->time_ms = time_ns_ / 1000000;
+        ev->op      = ( r < 10 ) ? op_e::LOGIN : ( r < 95 ) ? op_e::VALIDATE : op_e::CLOSE;
+        ev->user_id = 1 + rng_() % num_users_;
+
+        time_ns_ += step_ns_;
+
+        return true;
+    }
+
+private:
+    uint64_t        end_time_ms_;
+    uint32_t        num_users_;
+    uint64_t        step_ns_;
+    uint64_t        time_ns_;
+    std::mt19937    rng_;
+};
+
+// latency histogram of fixed size, so that the memory of the tool does not grow with the trace:
+// values are grouped by the power of 2 and split into 16 linear sub-buckets, i.e. the error is below 6.25%
+class Stats
+{
+public:
+
+    Stats():
+        count_( 0 ),
+        max_( 0 )
+    {
+        std::fill( std::begin( buckets_ ), std::end( buckets_ ), 0 );
+    }
+
+    void add( uint64_t latency_ns )
+    {
+        ++buckets_[ get_index( latency_ns ) ];
+        ++count_;
+
+        max_ = std::max( max_, latency_ns );
+    }
+
+    void print( const std::string & name ) const
+    {
+        if( count_ == 0 )
+        {
+            std::cout << name << ": no events" << std::endl;
+            return;
+        }
+
+        std::cout << name << ": count " << count_
+                << ", p50 " << get_percentile( 50.0 ) << " ns"
+                << ", p99 " << get_percentile( 99.0 ) << " ns"
+                << ", p99.9 " << get_percentile( 99.9 ) << " ns"
+                << ", max " << max_ << " ns" << std::endl;
+    }
+
+private:
+
+    static const uint32_t SUB_BUCKET_BITS   = 4;
+    static const uint32_t SUB_BUCKETS       = 1 << SUB_BUCKET_BITS;
+    static const uint32_t NUM_BUCKETS       = ( 64 - SUB_BUCKET_BITS + 1 ) * SUB_BUCKETS;
+
+    static uint32_t get_index( uint64_t v )
+    {
+        if( v < SUB_BUCKETS )
+            return static_cast<uint32_t>( v );
+
+        uint32_t msb = 63 - __builtin_clzll( v );
+
+        uint32_t sub = ( v >> ( msb - SUB_BUCKET_BITS ) ) & ( SUB_BUCKETS - 1 );
+
+        return ( msb - SUB_BUCKET_BITS + 1 ) * SUB_BUCKETS + sub;
+    }
+
+    // the smallest value of the bucket
+    static uint64_t get_value( uint32_t index )
+    {
+        if( index < SUB_BUCKETS )
+            return index;
+
+        uint32_t shift = index / SUB_BUCKETS - 1;
+
+        return uint64_t( SUB_BUCKETS + index % SUB_BUCKETS ) << shift;
+    }
+
+    uint64_t get_percentile( double p ) const
+    {
+        auto threshold = static_cast<uint64_t>( p / 100.0 * ( count_ - 1 ) );
+
+        uint64_t num = 0;
+
+        for( uint32_t i = 0; i < NUM_BUCKETS; ++i )
+        {
+            num += buckets_[i];
+
+            if( num > threshold )
+                return std::min( max_, ( i + 1 < NUM_BUCKETS ) ? get_value( i + 1 ) - 1 : max_ );
+        }
+
+        return max_;
+    }
+
+private:
+    uint64_t    buckets_[ NUM_BUCKETS ];
+    uint64_t    count_;
+    uint64_t    max_;
+};
+
+uint64_t get_rss_kb()
+{
+    std::ifstream statm( "/proc/self/statm" );
+
+    uint64_t size = 0, resident = 0;
+
+    statm >> size >> resident;
+
+    return resident * sysconf( _SC_PAGESIZE ) / 1024;
+}
+
+// the replay keeps own copies of session ids, so its RSS does not show the memory of sessions alone
+void report_memory_per_session( const session_manager::Config & config, uint32_t num_sessions )
+{
+    auto cfg = config;
+
+    // limits and the filter would distort the measurement
+    cfg.max_sessions    = 0;
+    cfg.max_memory_kb   = 0;
+    cfg.filter_size     = 0;
+    cfg.stats_file.clear();
+
+    Authenticator a;
+
+    session_manager::ManualClock clock( std::chrono::system_clock::now() );
+
+    session_manager::SessionManager m;
+
+    m.init( & a, cfg, & clock );
+
+    auto rss_before = get_rss_kb();
+
+    std::string session_id;
+    std::string error;
+
+    for( uint32_t i = 0; i < num_sessions; ++i )
+    {
+        if( m.authenticate( i + 1, "", session_id, error ) == false )
+            throw std::runtime_error( "memory probe: " + error );
+    }
+
+    auto rss_after = get_rss_kb();
+
+    session_manager::SessionManager::Stats stats;
+
+    m.get_stats( & stats );
+
+    std::cout << "memory per session, " << num_sessions << " sessions: estimated " << stats.memory_usage / num_sessions
+            << " bytes, RSS " << ( rss_after - rss_before ) * 1024 / num_sessions << " bytes" << std::endl;
+}
+
+void replay( session_manager::SessionManager & m, session_manager::ManualClock & clock, IEventSource & source, uint32_t max_sessions_per_user )
+{
+    auto start_time = clock.get_now();
+
+    std::map<uint32_t,std::deque<std::string>> user_sessions;
+
+    Stats stats_login, stats_validate, stats_close;
+
+    uint64_t num_events     = 0;
+    uint64_t num_failed     = 0;
+    uint64_t next_report_ms = 0;
+
+    Event ev;
+
+    while( source.get_next( & ev ) )
+    {
+        if( ev.time_ms >= next_report_ms )
+        {
+            session_manager::SessionManager::Stats stats;
+
+            m.get_stats( & stats );
+
+            std::cout << "hour " << next_report_ms / 3600000 << ": events " << num_events << ", sessions " << stats.num_sessions
+                    << ", session memory " << stats.memory_usage / 1024 << " KB";
+
+            if( stats.num_sessions )
+                std::cout << " (" << stats.memory_usage / stats.num_sessions << " bytes per session)";
+
+            std::cout << ", RSS " << get_rss_kb() << " KB" << std::endl;
+
+            next_report_ms += 3600000;
+        }
+
+        ++num_events;
+
+        clock.set_now( start_time + std::chrono::milliseconds( ev.time_ms ) );
+
+        auto & sessions = user_sessions[ ev.user_id ];
+
+        std::string error;
+
+        auto begin = std::chrono::steady_clock::now();
+
+        switch( ev.op )
+        {
+        case op_e::LOGIN:
+        {
+            std::string session_id;
+
+            if( m.authenticate( ev.user_id, "", session_id, error ) )
+            {
+                sessions.push_back( session_id );
+
+                // the manager accepted a new session, so the oldest ones beyond the limit have expired
+                if( sessions.size() > max_sessions_per_user )
+                    sessions.pop_front();
+            }
+            else
+            {
+                ++num_failed;
+            }
+
+            stats_login.add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - begin ).count() );
+            break;
+        }
+
+        case op_e::VALIDATE:
+        {
+            if( sessions.empty() || m.is_authenticated( sessions.back() ) == false )
+                ++num_failed;
+
+            stats_validate.add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - begin ).count() );
+            break;
+        }
+
+        case op_e::CLOSE:
+        {
+            if( sessions.empty() || m.close_session( sessions.front(), error ) == false )
+                ++num_failed;
+
+            stats_close.add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - begin ).count() );
+
+            if( sessions.empty() == false )
+                sessions.pop_front();
+            break;
+        }
+        }
+    }
+
+    stats_login.print( "login" );
+    stats_validate.print( "validate" );
+    stats_close.print( "close" );
+
+    std::cout << "failed operations (rejected logins, expired or unknown sessions): " << num_failed << std::endl;
+    std::cout << "RSS " << get_rss_kb() << " KB" << std::endl;
+}
+
+int main( int argc, char ** argv )
+{
+    if( argc != 3 && argc != 6 )
+    {
+        std::cout << "USAGE: replay <config.ini> <trace_file>\n"
+                << "       replay <config.ini> --synthetic <hours> <num_users> <events_per_sec>" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        config_reader::ConfigReader cr;
+
+        cr.init( argv[1] );
+
+        session_manager::Config cfg;
+
+        session_manager::init_config( & cfg, "session_manager", cr );
+
+        Authenticator a;
+
+        session_manager::ManualClock clock( std::chrono::system_clock::now() );
+
+        session_manager::SessionManager m;
+
+        m.init( & a, cfg, & clock );
+
+        if( argc == 3 )
+        {
+            TraceReader source( argv[2] );
+
+            replay( m, clock, source, cfg.max_sessions_per_user );
+        }
+        else
+        {
+            TraceGenerator source( std::stoul( argv[3] ), std::stoul( argv[4] ), std::stoul( argv[5] ) );
+
+            replay( m, clock, source, cfg.max_sessions_per_user );
+        }
+
+        report_memory_per_session( cfg, MEMORY_PROBE_SESSIONS );
+
+        return 0;
+    }
+    catch( std::exception & e )
+    {
+        std::cout << "ERROR: " << e.what() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+}
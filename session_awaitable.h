@@ -0,0 +1,102 @@
+/*
+
+Awaitable operations of the session manager for C++20 coroutines.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__SESSION_AWAITABLE_H
+#define SESSION_MANAGER__SESSION_AWAITABLE_H
+
+// opt-in: the library itself is C++14, this header is usable only by code built with coroutine support
+#if defined( __cpp_impl_coroutine )
+
+#include <coroutine>    // std::coroutine_handle
+#include <string>       // std::string
+
+#include "session_manager.h"    // SessionManager
+#include "i_executor.h"         // IExecutor
+
+namespace session_manager
+{
+
+// co_await authenticate_co( m, executor, user_id, password ) suspends the coroutine until the login
+// is done on the executor and resumes it on the thread of the executor with SessionManager::AuthResult.
+//
+// Validations need no awaitable: is_authenticated(), get_user_id(), get_session_info() and
+// is_authenticated_batch() take no lock, so a coroutine calls them directly without blocking its thread.
+class AuthenticateAwaitable
+{
+public:
+
+    AuthenticateAwaitable( SessionManager & m, IExecutor * executor, user_id_t user_id, const std::string & password, namespace_id_t ns ):
+        m_( m ),
+        executor_( executor ),
+        user_id_( user_id ),
+        password_( password ),
+        ns_( ns )
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    // the awaitable lives in the frame of the suspended coroutine, so the callback may fill it
+    void await_suspend( std::coroutine_handle<> handle )
+    {
+        m_.authenticate_async( executor_, user_id_, password_,
+                [this, handle]( bool is_ok, const std::string & session_id, const std::string & error )
+                {
+                    result_.is_ok       = is_ok;
+                    result_.session_id  = session_id;
+                    result_.error       = error;
+
+                    handle.resume();
+                },
+                ns_ );
+    }
+
+    SessionManager::AuthResult await_resume()
+    {
+        return result_;
+    }
+
+private:
+
+    SessionManager              & m_;
+    IExecutor                   * executor_;
+    user_id_t                   user_id_;
+    std::string                 password_;
+    namespace_id_t              ns_;
+
+    SessionManager::AuthResult  result_;
+};
+
+inline AuthenticateAwaitable authenticate_co( SessionManager & m, IExecutor * executor, user_id_t user_id, const std::string & password, namespace_id_t ns = SessionManager::DEFAULT_NAMESPACE )
+{
+    return AuthenticateAwaitable( m, executor, user_id, password, ns );
+}
+
+}
+
+#endif // __cpp_impl_coroutine
+
+#endif // SESSION_MANAGER__SESSION_AWAITABLE_H
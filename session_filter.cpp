@@ -0,0 +1,107 @@
+/*
+
+Session Manager - Session Filter.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "session_filter.h"     // self
+
+#include <cstring>              // memcpy
+
+#define NUM_HASHES          3
+#define COUNTER_SATURATED   255     // saturated counters are never decremented
+
+namespace session_manager
+{
+
+SessionFilter::SessionFilter():
+        size_( 0 )
+{
+}
+
+void SessionFilter::init( uint32_t size )
+{
+    size_   = size;
+
+    if( size_ == 0 )
+        return;
+
+    counters_.reset( new std::atomic<uint8_t>[ size_ ] );
+
+    for( uint32_t i = 0; i < size_; ++i )
+        counters_[i].store( 0, std::memory_order_relaxed );
+}
+
+bool SessionFilter::is_enabled() const
+{
+    return size_ > 0;
+}
+
+uint32_t SessionFilter::get_index( const SessionId & session_id, uint32_t i ) const
+{
+    // the version and variant bits of a UUID (bytes 6 and 8) are fixed, so the two hashes are taken
+    // from the fully random bytes 0-5 and 9-15 and combined by double hashing
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+
+    memcpy( & h1, session_id.data, 6 );
+    memcpy( & h2, session_id.data + 9, 7 );
+
+    return static_cast<uint32_t>( ( h1 + i * h2 ) % size_ );
+}
+
+void SessionFilter::add( const SessionId & session_id )
+{
+    for( uint32_t i = 0; i < NUM_HASHES; ++i )
+    {
+        auto & c = counters_[ get_index( session_id, i ) ];
+
+        auto v = c.load( std::memory_order_relaxed );
+
+        if( v != COUNTER_SATURATED )
+            c.store( v + 1, std::memory_order_release );
+    }
+}
+
+void SessionFilter::remove( const SessionId & session_id )
+{
+    for( uint32_t i = 0; i < NUM_HASHES; ++i )
+    {
+        auto & c = counters_[ get_index( session_id, i ) ];
+
+        auto v = c.load( std::memory_order_relaxed );
+
+        if( v != COUNTER_SATURATED && v != 0 )
+            c.store( v - 1, std::memory_order_release );
+    }
+}
+
+bool SessionFilter::may_contain( const SessionId & session_id ) const
+{
+    for( uint32_t i = 0; i < NUM_HASHES; ++i )
+    {
+        if( counters_[ get_index( session_id, i ) ].load( std::memory_order_acquire ) == 0 )
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace session_manager
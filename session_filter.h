@@ -0,0 +1,62 @@
+/*
+
+Session Manager - Session Filter.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__SESSION_FILTER_H
+#define SESSION_MANAGER__SESSION_FILTER_H
+
+#include <atomic>       // std::atomic
+#include <memory>       // std::unique_ptr
+
+#include "session_id.h" // SessionId
+
+namespace session_manager
+{
+
+// counting Bloom filter over live session ids: may_contain() never returns false for a live session,
+// but can return true for an unknown one; reading is lock-free, changes must be serialized by the caller
+class SessionFilter
+{
+public:
+    SessionFilter();
+
+    void init( uint32_t size );
+
+    bool is_enabled() const;
+
+    void add( const SessionId & session_id );
+    void remove( const SessionId & session_id );
+
+    bool may_contain( const SessionId & session_id ) const;
+
+private:
+
+    uint32_t get_index( const SessionId & session_id, uint32_t i ) const;
+
+private:
+    uint32_t                                    size_;
+    std::unique_ptr<std::atomic<uint8_t>[]>     counters_;
+};
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__SESSION_FILTER_H
@@ -0,0 +1,460 @@
+/*
+
+Session Manager - Session Handoff.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "session_handoff.h"    // self
+
+#include <stdexcept>            // std::runtime_error
+#include <cstring>              // memcpy
+#include <cerrno>               // errno
+#include <unistd.h>             // close, unlink
+#include <sys/socket.h>         // socket
+#include <sys/un.h>             // sockaddr_un
+
+#include "utils/dummy_logger.h"         // dummy_log
+
+#define MODULENAME      "SessionHandoff"
+
+#define HANDOFF_MAGIC       0x4F484D53      // "SMHO"
+#define HANDOFF_VERSION     2
+
+#define MAX_CHUNK_SIZE      100000
+#define MAX_ATTRIBUTES_SIZE 65535       // limit of SessionManager::set_attributes()
+
+// types of chunks
+#define CHUNK_END           0
+#define CHUNK_SESSIONS      1       // records of the walk, imported if they do not exist
+#define CHUNK_UPDATES       2       // records changed during the walk, replace the existing ones
+#define CHUNK_REMOVED       3       // ids of sessions removed during the walk
+
+namespace session_manager
+{
+
+namespace
+{
+
+// fixed part of the record, followed by attributes_size bytes of attributes
+struct Record
+{
+    uint8_t     session_id[16];
+    int64_t     start_time;         // unix time in seconds
+    int64_t     expiration_time;    // unix time in seconds
+    uint32_t    user_id;
+    uint32_t    attributes_size;
+    uint16_t    namespace_id;
+    uint16_t    reserved;
+};
+
+struct Header
+{
+    uint32_t    magic;
+    uint32_t    version;
+};
+
+struct ChunkHeader
+{
+    uint32_t    type;
+    uint32_t    num;        // number of records
+};
+
+void write_all( int fd, const void * data, std::size_t size )
+{
+    auto p = static_cast<const char*>( data );
+
+    while( size > 0 )
+    {
+        // no SIGPIPE if the peer is gone, the exporting process has to keep serving
+        auto res = send( fd, p, size, MSG_NOSIGNAL );
+
+        if( res < 0 && errno == EINTR )
+            continue;
+
+        if( res <= 0 )
+            throw std::runtime_error( "SessionHandoff: send failed, errno " + std::to_string( errno ) );
+
+        p       += res;
+        size    -= res;
+    }
+}
+
+void read_all( int fd, void * data, std::size_t size )
+{
+    auto p = static_cast<char*>( data );
+
+    while( size > 0 )
+    {
+        auto res = recv( fd, p, size, 0 );
+
+        if( res < 0 && errno == EINTR )
+            continue;
+
+        if( res < 0 )
+            throw std::runtime_error( "SessionHandoff: recv failed, errno " + std::to_string( errno ) );
+
+        if( res == 0 )
+            throw std::runtime_error( "SessionHandoff: unexpected end of stream" );
+
+        p       += res;
+        size    -= res;
+    }
+}
+
+int64_t to_unix_time( const std::chrono::system_clock::time_point & t )
+{
+    return std::chrono::duration_cast<std::chrono::seconds>( t.time_since_epoch() ).count();
+}
+
+std::chrono::system_clock::time_point from_unix_time( int64_t t )
+{
+    return std::chrono::system_clock::time_point( std::chrono::seconds( t ) );
+}
+
+// returns false if the record cannot be transferred
+bool encode( std::string * buffer, const SessionManager::SessionRecord & r )
+{
+    if( r.session_info.attributes.size() > MAX_ATTRIBUTES_SIZE )
+    {
+        dummy_log_warn( MODULENAME, "export_sessions: session %s skipped, attributes are too large: %u", r.session_id.c_str(), r.session_info.attributes.size() );
+        return false;
+    }
+
+    Record rec;
+
+    // no uninitialized padding bytes on the wire
+    memset( & rec, 0, sizeof( rec ) );
+
+    SessionId id;
+
+    parse_session_id( & id, r.session_id );
+
+    memcpy( rec.session_id, id.data, sizeof( rec.session_id ) );
+
+    rec.start_time      = to_unix_time( r.session_info.start_time );
+    rec.expiration_time = to_unix_time( r.session_info.expiration_time );
+    rec.user_id         = r.session_info.user_id;
+    rec.attributes_size = static_cast<uint32_t>( r.session_info.attributes.size() );
+    rec.namespace_id    = r.session_info.namespace_id;
+
+    buffer->append( reinterpret_cast<const char*>( & rec ), sizeof( rec ) );
+    buffer->append( r.session_info.attributes );
+
+    return true;
+}
+
+// sends the records in chunks of the given type, returns the number of sent records
+uint32_t send_records( int fd, uint32_t type, const std::vector<SessionManager::SessionRecord> & sessions, uint32_t chunk_size )
+{
+    uint32_t res = 0;
+
+    std::string buffer;
+
+    for( std::size_t i = 0; i < sessions.size(); i += chunk_size )
+    {
+        ChunkHeader chunk = { type, 0 };
+
+        // the header is filled in after encoding, as some records can be skipped
+        buffer.assign( sizeof( chunk ), '\0' );
+
+        for( std::size_t j = i; j < sessions.size() && j < i + chunk_size; ++j )
+        {
+            if( encode( & buffer, sessions[j] ) )
+                ++chunk.num;
+        }
+
+        if( chunk.num == 0 )
+            continue;
+
+        memcpy( & buffer[0], & chunk, sizeof( chunk ) );
+
+        write_all( fd, buffer.data(), buffer.size() );
+
+        res += chunk.num;
+    }
+
+    return res;
+}
+
+void send_removed( int fd, const std::vector<std::string> & session_ids, uint32_t chunk_size )
+{
+    std::string buffer;
+
+    for( std::size_t i = 0; i < session_ids.size(); i += chunk_size )
+    {
+        ChunkHeader chunk = { CHUNK_REMOVED, 0 };
+
+        buffer.assign( sizeof( chunk ), '\0' );
+
+        for( std::size_t j = i; j < session_ids.size() && j < i + chunk_size; ++j )
+        {
+            SessionId id;
+
+            if( parse_session_id( & id, session_ids[j] ) == false )
+                continue;
+
+            buffer.append( reinterpret_cast<const char*>( id.data ), sizeof( id.data ) );
+
+            ++chunk.num;
+        }
+
+        if( chunk.num == 0 )
+            continue;
+
+        memcpy( & buffer[0], & chunk, sizeof( chunk ) );
+
+        write_all( fd, buffer.data(), buffer.size() );
+    }
+}
+
+void read_records( int fd, std::vector<SessionManager::SessionRecord> * sessions )
+{
+    for( auto & s : * sessions )
+    {
+        Record rec;
+
+        read_all( fd, & rec, sizeof( rec ) );
+
+        if( rec.attributes_size > MAX_ATTRIBUTES_SIZE )
+            throw std::runtime_error( "SessionHandoff: attributes are too large: " + std::to_string( rec.attributes_size ) );
+
+        SessionId id;
+
+        memcpy( id.data, rec.session_id, sizeof( id.data ) );
+
+        s.session_id                        = to_string( id );
+        s.session_info.namespace_id         = rec.namespace_id;
+        s.session_info.user_id              = rec.user_id;
+        s.session_info.start_time           = from_unix_time( rec.start_time );
+        s.session_info.expiration_time      = from_unix_time( rec.expiration_time );
+
+        s.session_info.attributes.resize( rec.attributes_size );
+
+        if( rec.attributes_size )
+            read_all( fd, & s.session_info.attributes[0], rec.attributes_size );
+    }
+}
+
+void read_removed( int fd, std::vector<std::string> * session_ids )
+{
+    for( auto & s : * session_ids )
+    {
+        SessionId id;
+
+        read_all( fd, id.data, sizeof( id.data ) );
+
+        s = to_string( id );
+    }
+}
+
+int create_unix_socket( sockaddr_un * addr, const std::string & socket_path )
+{
+    if( socket_path.size() >= sizeof( addr->sun_path ) )
+        throw std::runtime_error( "SessionHandoff: socket path is too long: " + socket_path );
+
+    memset( addr, 0, sizeof( * addr ) );
+
+    addr->sun_family = AF_UNIX;
+
+    memcpy( addr->sun_path, socket_path.c_str(), socket_path.size() );
+
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+    if( fd < 0 )
+        throw std::runtime_error( "SessionHandoff: cannot create socket, errno " + std::to_string( errno ) );
+
+    return fd;
+}
+
+}
+
+uint32_t export_sessions( SessionManager & m, int fd, uint32_t chunk_size )
+{
+    // changes made behind the cursor are logged from now on
+    m.start_handoff();
+
+    try
+    {
+        Header header = { HANDOFF_MAGIC, HANDOFF_VERSION };
+
+        write_all( fd, & header, sizeof( header ) );
+
+        SessionManager::Cursor cursor;
+
+        uint32_t num_sessions = 0;
+
+        while( cursor.is_finished == false )
+        {
+            std::vector<SessionManager::SessionRecord> sessions;
+
+            m.get_sessions( & sessions, & cursor, chunk_size );
+
+            num_sessions += send_records( fd, CHUNK_SESSIONS, sessions, chunk_size );
+        }
+
+        // cutover: from now on the manager rejects changes, so the changes sent below are the last ones
+        std::vector<SessionManager::SessionRecord>  updates;
+        std::vector<std::string>                    removed;
+
+        m.freeze_for_handoff( & updates, & removed );
+
+        auto num_updates = send_records( fd, CHUNK_UPDATES, updates, chunk_size );
+
+        send_removed( fd, removed, chunk_size );
+
+        ChunkHeader end = { CHUNK_END, 0 };
+
+        write_all( fd, & end, sizeof( end ) );
+
+        dummy_log_info( MODULENAME, "export_sessions: sent %u sessions, %u updates, %u removals", num_sessions, num_updates, removed.size() );
+
+        return num_sessions + num_updates;
+    }
+    catch( ... )
+    {
+        // the peer did not get the end of the stream, so this process keeps serving
+        m.cancel_handoff();
+        throw;
+    }
+}
+
+uint32_t import_sessions( SessionManager & m, int fd )
+{
+    Header header;
+
+    read_all( fd, & header, sizeof( header ) );
+
+    if( header.magic != HANDOFF_MAGIC || header.version != HANDOFF_VERSION )
+        throw std::runtime_error( "SessionHandoff: unsupported stream, version " + std::to_string( header.version ) );
+
+    uint32_t num_received = 0;
+    uint32_t num_imported = 0;
+
+    while( true )
+    {
+        ChunkHeader chunk;
+
+        read_all( fd, & chunk, sizeof( chunk ) );
+
+        if( chunk.type == CHUNK_END )
+            break;
+
+        if( chunk.num > MAX_CHUNK_SIZE )
+            throw std::runtime_error( "SessionHandoff: chunk is too large: " + std::to_string( chunk.num ) );
+
+        // each chunk becomes visible to validations immediately
+        if( chunk.type == CHUNK_SESSIONS || chunk.type == CHUNK_UPDATES )
+        {
+            std::vector<SessionManager::SessionRecord> sessions( chunk.num );
+
+            read_records( fd, & sessions );
+
+            num_received += chunk.num;
+
+            if( chunk.type == CHUNK_SESSIONS )
+                num_imported += m.import_sessions( sessions );
+            else
+                num_imported += m.import_changes( sessions, std::vector<std::string>() );
+        }
+        else if( chunk.type == CHUNK_REMOVED )
+        {
+            std::vector<std::string> removed( chunk.num );
+
+            read_removed( fd, & removed );
+
+            m.import_changes( std::vector<SessionManager::SessionRecord>(), removed );
+        }
+        else
+        {
+            throw std::runtime_error( "SessionHandoff: unknown chunk type " + std::to_string( chunk.type ) );
+        }
+    }
+
+    dummy_log_info( MODULENAME, "import_sessions: received %u, imported %u sessions", num_received, num_imported );
+
+    return num_imported;
+}
+
+uint32_t serve_handoff( SessionManager & m, const std::string & socket_path )
+{
+    sockaddr_un addr;
+
+    int fd = create_unix_socket( & addr, socket_path );
+
+    unlink( socket_path.c_str() );
+
+    if( bind( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) ) != 0 || listen( fd, 1 ) != 0 )
+    {
+        close( fd );
+        throw std::runtime_error( "SessionHandoff: cannot listen on " + socket_path + ", errno " + std::to_string( errno ) );
+    }
+
+    int client_fd = accept( fd, nullptr, nullptr );
+
+    close( fd );
+
+    unlink( socket_path.c_str() );
+
+    if( client_fd < 0 )
+        throw std::runtime_error( "SessionHandoff: accept failed, errno " + std::to_string( errno ) );
+
+    try
+    {
+        auto res = export_sessions( m, client_fd );
+
+        close( client_fd );
+
+        return res;
+    }
+    catch( ... )
+    {
+        close( client_fd );
+        throw;
+    }
+}
+
+uint32_t receive_handoff( SessionManager & m, const std::string & socket_path )
+{
+    sockaddr_un addr;
+
+    int fd = create_unix_socket( & addr, socket_path );
+
+    if( connect( fd, reinterpret_cast<sockaddr*>( & addr ), sizeof( addr ) ) != 0 )
+    {
+        close( fd );
+        throw std::runtime_error( "SessionHandoff: cannot connect to " + socket_path + ", errno " + std::to_string( errno ) );
+    }
+
+    try
+    {
+        auto res = import_sessions( m, fd );
+
+        close( fd );
+
+        return res;
+    }
+    catch( ... )
+    {
+        close( fd );
+        throw;
+    }
+}
+
+} // namespace session_manager
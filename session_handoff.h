@@ -0,0 +1,70 @@
+/*
+
+Session Manager - Session Handoff.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__SESSION_HANDOFF_H
+#define SESSION_MANAGER__SESSION_HANDOFF_H
+
+#include <string>               // std::string
+
+#include "session_manager.h"    // SessionManager
+
+namespace session_manager
+{
+
+// Transfer of live sessions from an old process to a new one during an upgrade.
+//
+// The stream starts with a header (magic, version) followed by chunks: a chunk is its type, the number of records
+// and the records themselves. The sessions of the walk come first, then the sessions changed during the walk,
+// then the ids of the sessions removed during the walk, and an end chunk closes the stream. Each chunk is imported
+// in one critical section, so the new manager serves validations while the rest of the sessions are still
+// transferred.
+//
+// Contract of the cutover:
+//  - during the walk the old manager keeps serving validations and changes; logins, closes, set_attributes()
+//    and removals of expired or evicted sessions are logged, postponements are found by their expiration time,
+//    so the changes made behind the cursor of the walk are sent after it;
+//  - after the walk the old manager is frozen: logins, closes and set_attributes() fail, validations still
+//    succeed, but their postponements are not transferred anymore. So right after export_sessions() returns,
+//    the old process has to stop accepting requests and hand the traffic over to the new one;
+//  - if the export fails, the old manager accepts changes again and the new process must not take over;
+//  - when import_sessions() returns, the new manager holds every session which was alive in the old one
+//    at the cutover, with its latest attributes and expiration time.
+//
+// The functions throw std::runtime_error on I/O or format errors.
+
+// writes all sessions and the changes made meanwhile to a connected stream socket and freezes the manager,
+// returns the number of sent sessions and updates
+uint32_t export_sessions( SessionManager & m, int fd, uint32_t chunk_size = 1000 );
+
+// reads sessions from a connected stream socket, returns the number of imported sessions and updates
+uint32_t import_sessions( SessionManager & m, int fd );
+
+// old process: listens on the Unix-domain socket, exports sessions to the first client and freezes the manager
+uint32_t serve_handoff( SessionManager & m, const std::string & socket_path );
+
+// new process: connects to the Unix-domain socket of the old process and imports the sessions
+uint32_t receive_handoff( SessionManager & m, const std::string & socket_path );
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__SESSION_HANDOFF_H
@@ -0,0 +1,176 @@
+/*
+
+Session Manager - Session Id.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "session_id.h"     // self
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>      // SSE2 intrinsics
+#endif
+
+namespace session_manager
+{
+
+static const std::size_t SESSION_ID_LEN = 36;
+
+static bool is_dash_pos( std::size_t i )
+{
+    return i == 8 || i == 13 || i == 18 || i == 23;
+}
+
+// hex digit -> value, 0xFF for other characters; only lower-case digits are accepted
+struct HexTable
+{
+    uint8_t     values[256];
+
+    HexTable()
+    {
+        memset( values, 0xFF, sizeof( values ) );
+
+        for( int c = '0'; c <= '9'; ++c )
+            values[c] = static_cast<uint8_t>( c - '0' );
+
+        for( int c = 'a'; c <= 'f'; ++c )
+            values[c] = static_cast<uint8_t>( c - 'a' + 10 );
+    }
+};
+
+static const HexTable hex_table;
+
+// offsets of the hex digit pairs in the text form
+static const uint8_t pair_offsets[16] = { 0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34 };
+
+static bool is_valid_scalar( const char * p )
+{
+    for( std::size_t i = 0; i < SESSION_ID_LEN; ++i )
+    {
+        if( is_dash_pos( i ) )
+        {
+            if( p[i] != '-' )
+                return false;
+        }
+        else if( hex_table.values[ static_cast<uint8_t>( p[i] ) ] == 0xFF )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#if defined( __SSE2__ )
+
+// checks that the 16 characters at p are lower-case hex digits, except of the positions in dash_mask which must be '-'
+static bool is_valid_block( const char * p, int dash_mask )
+{
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+
+    // bytes >= 0x80 are negative in the signed comparisons below, so they are never accepted
+    const __m128i is_digit  = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( '0' - 1 ) ), _mm_cmplt_epi8( v, _mm_set1_epi8( '9' + 1 ) ) );
+    const __m128i is_letter = _mm_and_si128( _mm_cmpgt_epi8( v, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmplt_epi8( v, _mm_set1_epi8( 'f' + 1 ) ) );
+    const __m128i is_dash   = _mm_cmpeq_epi8( v, _mm_set1_epi8( '-' ) );
+
+    const int hex_mask  = _mm_movemask_epi8( _mm_or_si128( is_digit, is_letter ) );
+    const int dash      = _mm_movemask_epi8( is_dash );
+
+    return ( hex_mask == ( ~dash_mask & 0xFFFF ) ) && ( dash == dash_mask );
+}
+
+static bool is_valid( const char * p )
+{
+    // blocks 0..15, 16..31 and 20..35 cover all 36 characters; dashes are at 8, 13, 18, 23
+    return is_valid_block( p, ( 1 << 8 ) | ( 1 << 13 ) )
+        && is_valid_block( p + 16, ( 1 << ( 18 - 16 ) ) | ( 1 << ( 23 - 16 ) ) )
+        && is_valid_block( p + 20, ( 1 << ( 23 - 20 ) ) );
+}
+
+#else
+
+static bool is_valid( const char * p )
+{
+    return is_valid_scalar( p );
+}
+
+#endif // __SSE2__
+
+// converts the text which was already validated
+static void decode( SessionId * res, const char * p )
+{
+    for( std::size_t j = 0; j < sizeof( res->data ); ++j )
+    {
+        const char * c = p + pair_offsets[j];
+
+        res->data[j] = static_cast<uint8_t>( ( hex_table.values[ static_cast<uint8_t>( c[0] ) ] << 4 ) | hex_table.values[ static_cast<uint8_t>( c[1] ) ] );
+    }
+}
+
+bool parse_session_id( SessionId * res, const std::string & session_id )
+{
+    if( session_id.size() != SESSION_ID_LEN || is_valid( session_id.data() ) == false )
+        return false;
+
+    decode( res, session_id.data() );
+
+    return true;
+}
+
+bool parse_session_id_scalar( SessionId * res, const std::string & session_id )
+{
+    if( session_id.size() != SESSION_ID_LEN || is_valid_scalar( session_id.data() ) == false )
+        return false;
+
+    decode( res, session_id.data() );
+
+    return true;
+}
+
+bool is_equal_const_time( const SessionId & l, const SessionId & r )
+{
+    uint8_t diff = 0;
+
+    for( std::size_t j = 0; j < sizeof( l.data ); ++j )
+        diff |= l.data[j] ^ r.data[j];
+
+    return diff == 0;
+}
+
+std::string to_string( const SessionId & session_id )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    std::string res;
+
+    res.reserve( SESSION_ID_LEN );
+
+    for( std::size_t j = 0; j < sizeof( session_id.data ); ++j )
+    {
+        if( is_dash_pos( res.size() ) )
+            res += '-';
+
+        res += hex[ session_id.data[j] >> 4 ];
+        res += hex[ session_id.data[j] & 0x0F ];
+    }
+
+    return res;
+}
+
+} // namespace session_manager
@@ -0,0 +1,64 @@
+/*
+
+Session Manager - Session Id.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__SESSION_ID_H
+#define SESSION_MANAGER__SESSION_ID_H
+
+#include <cstdint>      // uint8_t
+#include <cstring>      // memcmp
+#include <string>       // std::string
+
+namespace session_manager
+{
+
+// binary form of the session id, i.e. of the UUID "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+struct SessionId
+{
+    uint8_t     data[16];
+};
+
+inline bool operator<( const SessionId & l, const SessionId & r )
+{
+    return memcmp( l.data, r.data, sizeof( l.data ) ) < 0;
+}
+
+inline bool operator==( const SessionId & l, const SessionId & r )
+{
+    return memcmp( l.data, r.data, sizeof( l.data ) ) == 0;
+}
+
+// converts the canonical lower-case text form into the binary one, returns false if the text is malformed;
+// the validation is vectorized (SSE2) where available, so malformed input is rejected in a few nanoseconds
+bool parse_session_id( SessionId * res, const std::string & session_id );
+
+// same as parse_session_id(), but validates character by character; the reference for the vectorized version
+bool parse_session_id_scalar( SessionId * res, const std::string & session_id );
+
+// comparison which time does not depend on the position of the first differing byte
+bool is_equal_const_time( const SessionId & l, const SessionId & r );
+
+std::string to_string( const SessionId & session_id );
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__SESSION_ID_H
@@ -25,279 +25,1350 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>          // std::assert
 #include <vector>           // std::vector
 #include <stdexcept>        // std::invalid_argument
+#include <algorithm>        // std::max, std::sort
 
 #include "i_authenticator.h"            // IAuthenticator
+#include "i_clock.h"                    // IClock
+#include "i_executor.h"                 // IExecutor
 
 #include "utils/gen_uuid.h"             // utils::gen_uuid
-#include "utils/mutex_helper.h"         // MUTEX_SCOPE_LOCK
 #include "utils/dummy_logger.h"         // dummy_log
 
 #define MODULENAME      "SessionManager"
 
+#define MAX_PROCESSED_PER_CALL  1000    // sessions visited by the reaper per second while the capacity is exceeded
+#define REAP_STEP               8       // sessions visited by the reaper on every change
+#define EVICTION_SAMPLE_SIZE    16      // sessions of which the one closest to expiry is evicted
+
+#define THREAD_CACHE_SIZE       64      // must be a power of 2
+
+#define HANDED_OFF_ERROR        "sessions were handed off to another process"
+
+// the epoch is set back, so that sessions imported from another manager can start before init()
+#define EPOCH_MARGIN_SEC        ( 365 * 24 * 3600 )
+
 
 namespace session_manager
 {
 
-SessionManager::SessionManager():
-        auth_( nullptr )
+namespace
+{
+
+struct ThreadCacheEntry
+{
+    uint32_t                    instance_id;    // 0 - empty entry
+    uint32_t                    expire;         // seconds relative to manager's epoch
+    uint64_t                    epoch;          // revocation epoch at the time of caching
+    bool                        postpone_expiration;    // requests of the user have to reach the session record
+    SessionId                   session_id;
+    SessionManager::SessionInfo session_info;
+};
+
+thread_local ThreadCacheEntry thread_cache[ THREAD_CACHE_SIZE ];
+
+std::atomic<uint32_t>   last_instance_id( 0 );
+
+class SystemClock: public IClock
+{
+public:
+
+    // interface IClock
+    virtual std::chrono::system_clock::time_point get_now() const
+    {
+        return std::chrono::system_clock::now();
+    }
+};
+
+SystemClock default_clock;
+
+ThreadCacheEntry & get_thread_cache_entry( const SessionId & session_id )
 {
+    // session ids are random, so any byte is a good enough hash
+    return thread_cache[ session_id.data[ sizeof( session_id.data ) - 1 ] & ( THREAD_CACHE_SIZE - 1 ) ];
+}
+
 }
 
-void SessionManager::init( IAuthenticator * auth, const Config & config )
+SessionManager::SessionManager():
+        instance_id_( ++last_instance_id ),
+        revocation_epoch_( 0 ),
+        num_sessions_( 0 ),
+        memory_usage_( 0 ),
+        next_stats_time_( 0 ),
+        num_logins_( 0 ),
+        num_login_failures_( 0 ),
+        num_expired_( 0 ),
+        num_evicted_( 0 ),
+        last_reap_duration_us_( 0 ),
+        auth_( nullptr ),
+        clock_( nullptr ),
+        is_reaper_started_( false ),
+        last_overflow_reap_time_( 0 ),
+        is_handoff_started_( false ),
+        is_frozen_( false ),
+        handoff_start_time_( 0 )
 {
-    assert( auth );
+    for( auto & b : config_blocks_ )
+        b.store( nullptr, std::memory_order_relaxed );
+}
 
+void SessionManager::check_config( const Config & config )
+{
     if( config.expiration_time_min == 0 )
         throw std::invalid_argument( "SessionManager: expiration_time_min == 0" );
 
     if( config.max_sessions_per_user == 0 )
         throw std::invalid_argument( "SessionManager: max_sessions_per_user == 0" );
+}
+
+void SessionManager::init( IAuthenticator * auth, const Config & config, IClock * clock )
+{
+    assert( auth );
+
+    check_config( config );
 
     auth_   = auth;
+    clock_  = clock ? clock : & default_clock;
     config_ = config;
+    epoch_  = std::chrono::time_point_cast<std::chrono::seconds>( clock_->get_now() ) - std::chrono::seconds( EPOCH_MARGIN_SEC );
+
+    publish_config( DEFAULT_NAMESPACE, config );
+
+    filter_.init( config.filter_size );
+
+    if( config.stats_file.empty() == false )
+        stats_publisher_.init( config.stats_file );
 
     dummy_log_info( MODULENAME, "init: OK" );
 }
 
-bool SessionManager::authenticate( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error )
+void SessionManager::add_namespace( namespace_id_t ns, const Config & config )
+{
+    check_config( config );
+
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    if( find_config( ns ) )
+        throw std::invalid_argument( "SessionManager: namespace " + std::to_string( ns ) + " already exists" );
+
+    publish_config( ns, config );
+
+    dummy_log_info( MODULENAME, "add_namespace: namespace %u, expiration_time_min %u, max_sessions_per_user %u", ns, config.expiration_time_min, config.max_sessions_per_user );
+}
+
+const Config * SessionManager::find_config( namespace_id_t ns ) const
 {
-    dummy_log_debug( MODULENAME, "authenticate: user %u, password ...", user_id );
+    auto block = config_blocks_[ ns >> 8 ].load( std::memory_order_acquire );
 
-    MUTEX_SCOPE_LOCK( mutex_ );
+    if( block == nullptr )
+        return nullptr;
+
+    return block->configs[ ns & 0xFF ].load( std::memory_order_acquire );
+}
 
-    remove_expired();
+void SessionManager::publish_config( namespace_id_t ns, const Config & config )
+{
+    auto & block = config_blocks_[ ns >> 8 ];
 
-    if( auth_->is_authenticated( user_id, password ) == false )
+    if( block.load( std::memory_order_relaxed ) == nullptr )
     {
-        error = "authentication failed";
-        return false;
+        config_block_storage_.push_back( std::unique_ptr<ConfigBlock>( new ConfigBlock() ) );
+
+        block.store( config_block_storage_.back().get(), std::memory_order_release );
     }
 
-    auto it = map_user_to_sessions_.find( user_id );
+    config_storage_.push_back( std::unique_ptr<Config>( new Config( config ) ) );
+
+    block.load( std::memory_order_relaxed )->configs[ ns & 0xFF ].store( config_storage_.back().get(), std::memory_order_release );
+}
+
+bool SessionManager::authenticate( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error, namespace_id_t ns )
+{
+    auto res = authenticate_impl( user_id, password, session_id, error, ns );
 
-    if( it == map_user_to_sessions_.end() )
+    if( stats_publisher_.is_enabled() )
     {
-        // user has no sessions yet
+        ( res ? num_logins_ : num_login_failures_ ).fetch_add( 1, std::memory_order_relaxed );
 
-        MapUserToSessionList::mapped_type sess_set;
+        publish_stats_if_due();
+    }
 
-        add_new_session( sess_set, user_id, session_id );
+    return res;
+}
 
-        {
-            bool _b = map_user_to_sessions_.insert( MapUserToSessionList::value_type( user_id, sess_set )).second;
+bool SessionManager::authenticate_impl( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error, namespace_id_t ns )
+{
+    dummy_log_debug( MODULENAME, "authenticate: namespace %u, user %u, password ...", ns, user_id );
 
-            assert( _b );
-        }
+    // cheap check, so that a flood of logins is rejected before reaching the authenticator
+    if( config_.evict_on_overflow == false && is_capacity_exceeded_after_reaping() )
+    {
+        error = "max number of sessions was reached";
+        return false;
     }
-    else
+
+    // the authenticator can be slow (hashing, external lookups), so it is called outside of the lock
+    // to avoid stalling the threads which only validate sessions
+    if( call_authenticator( user_id, password ) == false )
     {
-        if( it->second.size() == config_.max_sessions_per_user )
-        {
-            error = "max number of sessions was reached (" + std::to_string( config_.max_sessions_per_user ) + ")";
-            return false;
-        }
-        else
-        {
-            auto & sess_set = it->second;
+        error = "authentication failed";
+        return false;
+    }
 
-            add_new_session( sess_set, user_id, session_id );
-        }
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    if( is_frozen_ )
+    {
+        error = HANDED_OFF_ERROR;
+        return false;
+    }
+
+    auto config = find_config( ns );
+
+    if( config == nullptr )
+    {
+        error = "unknown namespace " + std::to_string( ns );
+        return false;
     }
 
-    dummy_log_debug( MODULENAME, "authenticate: OK: user %u, session_id %s", user_id, session_id.c_str() );
+    remove_expired( REAP_STEP );
+
+    if( create_session( * config, ns, user_id, session_id, error ) == false )
+        return false;
+
+    dummy_log_debug( MODULENAME, "authenticate: OK: namespace %u, user %u, session_id %s", ns, user_id, session_id.c_str() );
 
     return true;
 }
 
-bool SessionManager::close_session( const std::string & session_id, std::string & error )
+bool SessionManager::call_authenticator( user_id_t user_id, const std::string & password )
 {
-    MUTEX_SCOPE_LOCK( mutex_ );
+    if( auth_->is_thread_safe() )
+        return auth_->is_authenticated( user_id, password );
+
+    std::lock_guard<std::mutex> auth_lock( auth_mutex_ );
 
-    return remove_session( session_id, error );
+    return auth_->is_authenticated( user_id, password );
 }
 
-bool SessionManager::remove_session( const std::string & session_id, std::string & error )
+void SessionManager::authenticate_async( IExecutor * executor, user_id_t user_id, const std::string & password, const AuthCallback & callback, namespace_id_t ns )
 {
-    dummy_log_debug( MODULENAME, "remove_session: session %s", session_id.c_str() );
+    dummy_log_debug( MODULENAME, "authenticate_async: namespace %u, user %u, password ...", ns, user_id );
 
-    {
-        // remove session from session map
-        auto it = map_sessions_.find( session_id );
+    executor->post( [this, user_id, password, callback, ns]()
+            {
+                std::string session_id;
+                std::string error;
+
+                auto res = authenticate( user_id, password, session_id, error, ns );
 
-        if( it == map_sessions_.end() )
+                callback( res, session_id, error );
+            } );
+}
+
+void SessionManager::authenticate_batch( std::vector<AuthResult> * results, const std::vector<Credentials> & credentials, namespace_id_t ns )
+{
+    dummy_log_debug( MODULENAME, "authenticate_batch: namespace %u, %u users", ns, credentials.size() );
+
+    results->assign( credentials.size(), AuthResult() );
+
+    if( config_.evict_on_overflow == false && is_capacity_exceeded_after_reaping() )
+    {
+        for( auto & r : * results )
         {
-            error = "invalid session id or session has already expired";
-            return false;
+            r.is_ok = false;
+            r.error = "max number of sessions was reached";
         }
 
-        map_sessions_.erase( it );
+        return;
     }
 
-    user_id_t user_id;
+    std::vector<uint8_t> is_authenticated;
+
     {
-        // remove session from session-to-user map
-        auto it = map_session_to_user_.find( session_id );
+        std::unique_lock<std::mutex> auth_lock( auth_mutex_, std::defer_lock );
 
-        assert( it != map_session_to_user_.end() );
+        if( auth_->is_thread_safe() == false )
+            auth_lock.lock();
 
-        user_id = it->second;
+        auth_->is_authenticated_batch( & is_authenticated, credentials );
+    }
+
+    if( is_authenticated.size() != credentials.size() )
+    {
+        // broken override, no credentials can be trusted
+        dummy_log_error( MODULENAME, "authenticate_batch: authenticator returned %u results for %u users", is_authenticated.size(), credentials.size() );
 
-        map_session_to_user_.erase( it );
+        is_authenticated.assign( credentials.size(), 0 );
     }
 
+    std::unique_lock<std::shared_timed_mutex> lock( mutex_ );
+
+    auto config = find_config( ns );
+
+    remove_expired( REAP_STEP );
+
+    std::size_t num_ok = 0;
+
+    for( std::size_t i = 0; i < credentials.size(); ++i )
     {
-        // remove session from user-to-session map
-        auto it = map_user_to_sessions_.find( user_id );
+        auto & r = ( * results )[i];
 
-        assert( it != map_user_to_sessions_.end() );
+        r.is_ok = false;
 
-        auto _num_del = it->second.erase( session_id );
+        if( is_authenticated[i] == 0 )
+            r.error = "authentication failed";
+        else if( is_frozen_ )
+            r.error = HANDED_OFF_ERROR;
+        else if( config == nullptr )
+            r.error = "unknown namespace " + std::to_string( ns );
+        else
+            r.is_ok = create_session( * config, ns, credentials[i].user_id, r.session_id, r.error );
 
-        assert( _num_del > 0 );
+        if( r.is_ok )
+            ++num_ok;
     }
 
-    return true;
+    lock.unlock();
+
+    dummy_log_debug( MODULENAME, "authenticate_batch: OK: %u of %u users", num_ok, credentials.size() );
+
+    if( stats_publisher_.is_enabled() )
+    {
+        num_logins_.fetch_add( num_ok, std::memory_order_relaxed );
+        num_login_failures_.fetch_add( credentials.size() - num_ok, std::memory_order_relaxed );
+
+        publish_stats_if_due();
+    }
 }
 
-void SessionManager::remove_expired()
+bool SessionManager::create_session( const Config & config, namespace_id_t ns, user_id_t user_id, std::string & session_id, std::string & error )
 {
-    std::size_t num_expired = 0;
+    // the reaper may not have reached user's sessions yet, so drop the ones which are already expired
+    remove_expired( ns, user_id );
+
+    // checked before the eviction, so that a login which is rejected anyway does not evict other sessions
+    if( get_num_user_sessions( ns, user_id ) >= config.max_sessions_per_user )
+    {
+        error = "max number of sessions was reached (" + std::to_string( config.max_sessions_per_user ) + ")";
+        return false;
+    }
 
-    std::vector<std::string>    expired_sessions;
+    // expired sessions count until the reaper reaches them, the eviction prefers them anyway
+    if( config_.evict_on_overflow == false && is_capacity_exceeded() )
+        remove_expired_on_overflow();
 
-    for( auto & v : map_sessions_ )
+    if( is_capacity_exceeded() )
     {
-        if( v.second.is_expired() )
+        if( config_.evict_on_overflow == false )
         {
-            num_expired++;
-            expired_sessions.push_back( v.first );
+            error = "max number of sessions was reached";
+            return false;
         }
-    }
 
-    std::string error;
+        while( is_capacity_exceeded() && evict_session() )
+        {
+        }
 
-    for( auto & s : expired_sessions )
-    {
-        remove_session( s, error );
+        // nothing was left to evict, e.g. the limit of memory is below the size of one session
+        if( is_capacity_exceeded() )
+        {
+            error = "max number of sessions was reached";
+            return false;
+        }
     }
 
-    dummy_log_debug( MODULENAME, "remove_expired: number of expired sessions = %u", num_expired );
-}
+    add_new_session( config, ns, user_id, session_id );
 
-void SessionManager::init_new_session( Session & sess )
-{
-    sess.started    = std::chrono::system_clock::now();
-    sess.expire     = sess.started + std::chrono::minutes( config_.expiration_time_min );
+    return true;
 }
 
-void SessionManager::postpone_expiration( Session & sess )
+bool SessionManager::close_session( const std::string & session_id, std::string & error, namespace_id_t ns )
 {
-    sess.expire     = std::chrono::system_clock::now() + std::chrono::minutes( config_.expiration_time_min );
+    dummy_log_debug( MODULENAME, "close_session: session %s", session_id.c_str() );
+
+    SessionId id;
+
+    if( parse_session_id( & id, session_id ) == false )
+    {
+        error = "invalid session id or session has already expired";
+        return false;
+    }
+
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    if( is_frozen_ )
+    {
+        error = HANDED_OFF_ERROR;
+        return false;
+    }
+
+    remove_expired( REAP_STEP );
+
+    auto sess = table_.find( id );
+
+    if( sess == nullptr || sess->namespace_id != ns )
+    {
+        error = "invalid session id or session has already expired";
+        return false;
+    }
+
+    return remove_session( id, error );
 }
 
-void SessionManager::add_new_session( MapUserToSessionList::mapped_type & sess_set, user_id_t user_id, std::string & session_id )
+bool SessionManager::set_attributes( const std::string & session_id, const std::string & attributes, std::string & error, namespace_id_t ns )
 {
-    Session sess;
+    dummy_log_debug( MODULENAME, "set_attributes: session %s, size %u", session_id.c_str(), attributes.size() );
 
-    init_new_session( sess );
+    SessionId id;
 
-    session_id = utils::gen_uuid();
+    if( parse_session_id( & id, session_id ) == false )
+    {
+        error = "invalid session id or session has already expired";
+        return false;
+    }
 
-    dummy_log_debug( MODULENAME, "add_new_session: session %s, user %u", session_id.c_str(), user_id );
+    if( attributes.size() > Session::MAX_ATTRIBUTES_SIZE )
+    {
+        error = "attributes are too large, max size " + std::to_string( Session::MAX_ATTRIBUTES_SIZE );
+        return false;
+    }
 
-    sess_set.insert( session_id );
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
 
+    if( is_frozen_ )
     {
-        bool _b = map_sessions_.insert( MapSessionIdToSession::value_type( session_id, sess )).second;
-
-        assert( _b );
+        error = HANDED_OFF_ERROR;
+        return false;
     }
 
+    auto sess = table_.find( id );
+
+    if( sess == nullptr || sess->namespace_id != ns || sess->is_expired( get_now() ) )
     {
-        bool _b = map_session_to_user_.insert( MapSessionIdToUser::value_type( session_id, user_id )).second;
+        error = "invalid session id or session has already expired";
+        return false;
+    }
 
-        assert( _b );
+    auto old_size = get_session_size( sess->attributes_size );
+    auto new_size = get_session_size( attributes.size() );
+
+    if( config_.max_memory_kb && memory_usage_ - old_size + new_size > uint64_t( config_.max_memory_kb ) * 1024 )
+    {
+        error = "memory limit of sessions was reached";
+        return false;
     }
 
-    dummy_log_debug( MODULENAME, "add_new_session: total number of sessions = %u", map_sessions_.size() );
+    // lock-free readers may be reading the record, so it is replaced by an updated copy
+    table_.set_attributes( id, attributes );
+
+    if( is_handoff_started_ )
+        handoff_changes_.push_back( id );
+
+    memory_usage_ += new_size;
+    memory_usage_ -= old_size;
+
+    // thread caches hold copies of the attributes
+    revocation_epoch_.fetch_add( 1, std::memory_order_release );
+
+    return true;
 }
 
-bool SessionManager::get_associated_session( SessionInfo * session_info, const std::string & session_id, bool is_user_request )
+bool SessionManager::remove_session( const SessionId & session_id, std::string & error )
 {
-    remove_expired();
-
-    auto it = map_sessions_.find( session_id );
+    // remove session from session table
+    auto sess = table_.find( session_id );
 
-    if( it == map_sessions_.end() )
+    if( sess == nullptr )
     {
-        dummy_log_debug( MODULENAME, "get_associated_session: unknown session_id %s", session_id.c_str() );
+        error = "invalid session id or session has already expired";
         return false;
     }
 
-    auto & session = it->second;
+    auto ns         = sess->namespace_id;
+    auto user_id    = sess->user_id;
+
+    memory_usage_ -= get_session_size( sess->attributes_size );
+    num_sessions_--;
+
+    table_.erase( session_id );
+
+    if( filter_.is_enabled() )
+        filter_.remove( session_id );
+
+    if( is_handoff_started_ )
+        handoff_changes_.push_back( session_id );
+
+    revocation_epoch_.fetch_add( 1, std::memory_order_release );
+
+    auto num_user_sessions = get_num_user_sessions( ns, user_id );
+
+    update_user_histogram( num_user_sessions + 1, num_user_sessions );
+
+    return true;
+}
+
+Session * SessionManager::get_reaper_start() const
+{
+    auto res = is_reaper_started_ ? table_.upper_bound( reaper_position_ ) : nullptr;
+
+    return res ? res : table_.get_first();
+}
+
+Session * SessionManager::get_reaper_next( const Session * sess ) const
+{
+    auto res = table_.get_next( sess );
+
+    return res ? res : table_.get_first();
+}
+
+void SessionManager::remove_expired( std::size_t max_visited )
+{
+    // the work per call is bounded to avoid long exclusive lock holds, the next calls continue the walk;
+    // there is no expiration index, so that a session costs only its record in the table
+    std::size_t num_visited = std::min( max_visited, table_.size() );
+    std::size_t num_expired = 0;
+
+    if( num_visited == 0 )
+        return;
 
-    auto it_user = map_session_to_user_.find( session_id );
+    auto begin = std::chrono::steady_clock::now();
 
-    assert( it_user != map_session_to_user_.end() );
+    auto now = get_now();
 
-    session_info->user_id           = it_user->second;
-    session_info->start_time        = it->second.started;
-    session_info->expiration_time   = it->second.expire;
+    auto sess = get_reaper_start();
 
-    if( config_.postpone_expiration && is_user_request )
+    for( std::size_t i = 0; i < num_visited; ++i )
     {
-        postpone_expiration( session );
+        // the next session is taken before the current one is removed
+        auto next = get_reaper_next( sess );
+
+        auto id = sess->id;
+
+        is_reaper_started_  = true;
+        reaper_position_    = id;
+
+        if( sess->is_expired( now ) )
+        {
+            num_expired++;
+
+            std::string error;
+
+            remove_session( id, error );
+        }
+
+        sess = next;
     }
 
-    dummy_log_debug( MODULENAME, "get_associated_session: session_id %s, user_id %u", session_id.c_str(), session_info->user_id );
+    num_expired_.fetch_add( num_expired, std::memory_order_relaxed );
 
-    return true;
+    last_reap_duration_us_.store( std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - begin ).count(), std::memory_order_relaxed );
+
+    if( num_expired )
+        dummy_log_debug( MODULENAME, "remove_expired: number of expired sessions = %u", num_expired );
 }
 
-bool SessionManager::is_authenticated( const std::string & session_id )
+void SessionManager::remove_expired_on_overflow()
 {
-    SessionInfo dummy;
+    // a flood of logins which are rejected for the capacity must not walk the table on every attempt
+    auto now = get_now();
 
-    MUTEX_SCOPE_LOCK( mutex_ );
+    if( now == last_overflow_reap_time_ )
+        return;
 
-    auto res = get_associated_session( & dummy, session_id, true );
+    last_overflow_reap_time_ = now;
 
-    dummy_log_debug( MODULENAME, "is_authenticated: %s: session_id %s", res ? "OK" : "NO", session_id.c_str() );
+    remove_expired( MAX_PROCESSED_PER_CALL );
+}
+
+void SessionManager::remove_expired( namespace_id_t ns, user_id_t user_id )
+{
+    auto now = get_now();
+
+    std::vector<SessionId>  expired_sessions;
+
+    for( auto sess = table_.get_first_of_user( ns, user_id ); sess != nullptr; sess = table_.get_next_of_user( sess ) )
+    {
+        if( sess->is_expired( now ) )
+            expired_sessions.push_back( sess->id );
+    }
+
+    std::string error;
+
+    for( auto & s : expired_sessions )
+    {
+        remove_session( s, error );
+    }
+}
+
+std::size_t SessionManager::get_num_user_sessions( namespace_id_t ns, user_id_t user_id ) const
+{
+    std::size_t res = 0;
+
+    for( auto sess = table_.get_first_of_user( ns, user_id ); sess != nullptr; sess = table_.get_next_of_user( sess ) )
+        ++res;
 
     return res;
 }
 
-bool SessionManager::get_user_id( user_id_t * user_id, const std::string & session_id )
+bool SessionManager::is_capacity_exceeded() const
 {
-    dummy_log_trace( MODULENAME, "get_user_id: session_id %s", session_id.c_str() );
+    if( config_.max_sessions && num_sessions_ >= config_.max_sessions )
+        return true;
 
-    SessionInfo dummy;
+    if( config_.max_memory_kb && memory_usage_ + get_session_size( 0 ) > uint64_t( config_.max_memory_kb ) * 1024 )
+        return true;
 
-    MUTEX_SCOPE_LOCK( mutex_ );
+    return false;
+}
 
-    auto res = get_associated_session( & dummy, session_id, false );
+bool SessionManager::is_capacity_exceeded_after_reaping()
+{
+    if( is_capacity_exceeded() == false )
+        return false;
 
-    * user_id = dummy.user_id;
+    // the counters include expired sessions which the reaper has not reached yet;
+    // if the lock is busy, the thread holding it reaps
+    std::unique_lock<std::shared_timed_mutex> lock( mutex_, std::try_to_lock );
 
-    dummy_log_debug( MODULENAME, "get_user_id: session_id %s, user id %u", session_id.c_str(), * user_id );
+    if( lock.owns_lock() )
+        remove_expired_on_overflow();
 
-    return res;
+    return is_capacity_exceeded();
 }
 
-bool SessionManager::get_session_info( SessionInfo * session_info, const std::string & session_id )
+bool SessionManager::evict_session()
 {
-    dummy_log_trace( MODULENAME, "get_session_info: session_id %s", session_id.c_str() );
+    // removes the session closest to expiry of a sample taken at the position of the reaper,
+    // returns false if there are no sessions
+
+    auto num_sampled = std::min<std::size_t>( EVICTION_SAMPLE_SIZE, table_.size() );
+
+    if( num_sampled == 0 )
+        return false;
+
+    auto sess   = get_reaper_start();
+    auto victim = sess;
+
+    for( std::size_t i = 0; i < num_sampled; ++i, sess = get_reaper_next( sess ) )
+    {
+        if( sess->get_expire() < victim->get_expire() )
+            victim = sess;
+
+        // the next eviction samples the following sessions
+        is_reaper_started_  = true;
+        reaper_position_    = sess->id;
+    }
+
+    auto id = victim->id;
+
+    dummy_log_debug( MODULENAME, "evict_session: session %s, user %u", to_string( id ).c_str(), victim->user_id );
+
+    std::string error;
+
+    remove_session( id, error );
+
+    num_evicted_.fetch_add( 1, std::memory_order_relaxed );
+
+    return true;
+}
+
+std::size_t SessionManager::get_session_size( std::size_t attributes_size )
+{
+    return SessionTable::get_session_memory( attributes_size );
+}
+
+uint32_t SessionManager::get_now() const
+{
+    return static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::seconds>( clock_->get_now() - epoch_ ).count() );
+}
 
-    MUTEX_SCOPE_LOCK( mutex_ );
+std::chrono::system_clock::time_point SessionManager::to_time_point( uint32_t t ) const
+{
+    return epoch_ + std::chrono::seconds( t );
+}
+
+uint32_t SessionManager::to_offset( const std::chrono::system_clock::time_point & t ) const
+{
+    auto res = std::chrono::duration_cast<std::chrono::seconds>( t - epoch_ ).count();
 
-    return get_associated_session( session_info, session_id, false );
+    if( res < 0 )
+        return 0;
+
+    return static_cast<uint32_t>( std::min<decltype( res )>( res, UINT32_MAX ) );
 }
 
-bool SessionManager::Session::is_expired() const
+void SessionManager::postpone_expiration( Session & sess )
 {
-    auto now = std::chrono::system_clock::now();
+    auto config = find_config( sess.namespace_id );
+
+    assert( config );
+
+    auto expire = get_now() + config->expiration_time_min * 60;
 
-    return ( now >= expire ) ? true : false;
+    // set_attributes() may have replaced the record since it was found, then the replacement is postponed
+    for( auto s = & sess; s != nullptr && s->postpone( expire ) == false; )
+    {
+        s = table_.find( sess.id );
+    }
+}
+
+void SessionManager::add_new_session( const Config & config, namespace_id_t ns, user_id_t user_id, std::string & session_id )
+{
+    auto now = get_now();
+
+    session_id = utils::gen_uuid();
+
+    SessionId id;
+
+    {
+        bool _b = parse_session_id( & id, session_id );
+
+        assert( _b );
+    }
+
+    dummy_log_debug( MODULENAME, "add_new_session: session %s, user %u", session_id.c_str(), user_id );
+
+    insert_session( id, ns, user_id, now, now + config.expiration_time_min * 60, std::string() );
+}
+
+void SessionManager::insert_session( const SessionId & id, namespace_id_t ns, user_id_t user_id, uint32_t started, uint32_t expire, const std::string & attributes )
+{
+    if( filter_.is_enabled() )
+        filter_.add( id );
+
+    memory_usage_ += get_session_size( attributes.size() );
+    num_sessions_++;
+
+    // the record becomes visible to readers
+    table_.insert( id, ns, user_id, started, expire, attributes );
+
+    if( is_handoff_started_ )
+        handoff_changes_.push_back( id );
+
+    auto num_user_sessions = get_num_user_sessions( ns, user_id );
+
+    update_user_histogram( num_user_sessions - 1, num_user_sessions );
+
+    dummy_log_debug( MODULENAME, "insert_session: total number of sessions = %u", table_.size() );
+}
+
+void SessionManager::fill_session_info( SessionInfo * session_info, const Session & session ) const
+{
+    session_info->namespace_id      = session.namespace_id;
+    session_info->user_id           = session.user_id;
+    session_info->start_time        = to_time_point( session.started );
+    session_info->expiration_time   = to_time_point( session.get_expire() );
+    session_info->attributes.assign( session.get_attributes(), session.attributes_size );
+}
+
+bool SessionManager::get_associated_session( SessionInfo * session_info, const SessionId & session_id, namespace_id_t ns, bool is_user_request )
+{
+    // called inside of a read guard: expired sessions are not removed here, but treated as unknown
+
+    auto sess = table_.find( session_id );
+
+    if( sess == nullptr || sess->namespace_id != ns )
+    {
+        return false;
+    }
+
+    auto & session = * sess;
+
+    if( session.is_expired( get_now() ) )
+    {
+        return false;
+    }
+
+    fill_session_info( session_info, session );
+
+    if( is_user_request && find_config( ns )->postpone_expiration )
+    {
+        postpone_expiration( session );
+    }
+
+    return true;
+}
+
+void SessionManager::count_filter_miss( const SessionId & session_id )
+{
+    // called inside of a read guard: only ids missing in the index are false positives of the filter,
+    // expired sessions and sessions of other namespaces were correctly passed
+    if( filter_.is_enabled() && table_.find( session_id ) == nullptr )
+        num_filter_passed_.add( 1 );
+}
+
+bool SessionManager::validate( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns, bool is_user_request )
+{
+    auto res = validate_impl( session_info, session_id, ns, is_user_request );
+
+    if( stats_publisher_.is_enabled() )
+    {
+        ( res ? num_validations_ : num_validation_failures_ ).add( 1 );
+
+        publish_stats_if_due();
+    }
+
+    return res;
+}
+
+bool SessionManager::validate_impl( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns, bool is_user_request )
+{
+    SessionId id;
+
+    if( parse_session_id( & id, session_id ) == false )
+    {
+        dummy_log_debug( MODULENAME, "validate: malformed session_id %s", session_id.c_str() );
+        return false;
+    }
+
+    if( config_.use_thread_cache && find_in_thread_cache( session_info, id, ns, is_user_request ) )
+        return true;
+
+    // most of unknown ids (scanners, stale clients) are rejected here without touching the lock
+    if( filter_.is_enabled() && filter_.may_contain( id ) == false )
+    {
+        num_filter_rejected_.add( 1 );
+        return false;
+    }
+
+    // read before the lookup: a session removed after this point invalidates the cached entry
+    auto epoch = revocation_epoch_.load( std::memory_order_acquire );
+
+    SessionTable::ReadGuard guard( table_ );
+
+    auto res = get_associated_session( session_info, id, ns, is_user_request );
+
+    if( res == false )
+        count_filter_miss( id );
+
+    if( res && config_.use_thread_cache )
+        add_to_thread_cache( * session_info, id, epoch );
+
+    return res;
+}
+
+bool SessionManager::find_in_thread_cache( SessionInfo * session_info, const SessionId & session_id, namespace_id_t ns, bool is_user_request ) const
+{
+    auto & e = get_thread_cache_entry( session_id );
+
+    if( e.instance_id != instance_id_ || is_equal_const_time( e.session_id, session_id ) == false || e.session_info.namespace_id != ns )
+        return false;
+
+    // postponing the expiration has to reach the shared session record, so such requests bypass the cache
+    if( is_user_request && e.postpone_expiration )
+        return false;
+
+    if( e.epoch != revocation_epoch_.load( std::memory_order_acquire ) )
+        return false;
+
+    if( get_now() >= e.expire )
+        return false;
+
+    * session_info = e.session_info;
+
+    return true;
+}
+
+void SessionManager::add_to_thread_cache( const SessionInfo & session_info, const SessionId & session_id, uint64_t epoch ) const
+{
+    auto & e = get_thread_cache_entry( session_id );
+
+    e.instance_id   = instance_id_;
+    e.expire        = static_cast<uint32_t>( std::chrono::duration_cast<std::chrono::seconds>( session_info.expiration_time - epoch_ ).count() );
+    e.epoch         = epoch;
+    e.postpone_expiration   = find_config( session_info.namespace_id )->postpone_expiration;
+    e.session_id    = session_id;
+    e.session_info  = session_info;
+}
+
+bool SessionManager::is_authenticated( const std::string & session_id, namespace_id_t ns )
+{
+    SessionInfo dummy;
+
+    auto res = validate( & dummy, session_id, ns, true );
+
+    dummy_log_debug( MODULENAME, "is_authenticated: %s: session_id %s", res ? "OK" : "NO", session_id.c_str() );
+
+    return res;
+}
+
+void SessionManager::is_authenticated_batch( std::vector<uint8_t> * results, std::vector<user_id_t> * user_ids, const std::vector<std::string> & session_ids, namespace_id_t ns )
+{
+    dummy_log_trace( MODULENAME, "is_authenticated_batch: namespace %u, %u sessions", ns, session_ids.size() );
+
+    results->assign( session_ids.size(), 0 );
+
+    if( user_ids )
+        user_ids->assign( session_ids.size(), 0 );
+
+    std::vector<SessionId>      ids( session_ids.size() );
+    std::vector<std::size_t>    pending;    // indices of ids which need a lookup in the index
+
+    SessionInfo info;
+
+    std::size_t num_ok = 0;
+
+    for( std::size_t i = 0; i < session_ids.size(); ++i )
+    {
+        if( parse_session_id( & ids[i], session_ids[i] ) == false )
+            continue;
+
+        if( config_.use_thread_cache && find_in_thread_cache( & info, ids[i], ns, true ) )
+        {
+            ( * results )[i] = 1;
+
+            if( user_ids )
+                ( * user_ids )[i] = info.user_id;
+
+            ++num_ok;
+            continue;
+        }
+
+        if( filter_.is_enabled() && filter_.may_contain( ids[i] ) == false )
+        {
+            num_filter_rejected_.add( 1 );
+            continue;
+        }
+
+        pending.push_back( i );
+    }
+
+    if( pending.empty() == false )
+    {
+        auto epoch = revocation_epoch_.load( std::memory_order_acquire );
+
+        SessionTable::ReadGuard guard( table_ );
+
+        for( auto i : pending )
+        {
+            if( get_associated_session( & info, ids[i], ns, true ) == false )
+            {
+                count_filter_miss( ids[i] );
+                continue;
+            }
+
+            ( * results )[i] = 1;
+
+            if( user_ids )
+                ( * user_ids )[i] = info.user_id;
+
+            ++num_ok;
+
+            if( config_.use_thread_cache )
+                add_to_thread_cache( info, ids[i], epoch );
+        }
+    }
+
+    dummy_log_debug( MODULENAME, "is_authenticated_batch: OK: %u of %u sessions", num_ok, session_ids.size() );
+
+    if( stats_publisher_.is_enabled() )
+    {
+        num_validations_.add( num_ok );
+        num_validation_failures_.add( session_ids.size() - num_ok );
+
+        publish_stats_if_due();
+    }
+}
+
+bool SessionManager::get_user_id( user_id_t * user_id, const std::string & session_id, namespace_id_t ns )
+{
+    dummy_log_trace( MODULENAME, "get_user_id: session_id %s", session_id.c_str() );
+
+    SessionInfo dummy;
+
+    auto res = validate( & dummy, session_id, ns, false );
+
+    if( res )
+        * user_id = dummy.user_id;
+
+    dummy_log_debug( MODULENAME, "get_user_id: %s: session_id %s", res ? "OK" : "NO", session_id.c_str() );
+
+    return res;
+}
+
+bool SessionManager::get_session_info( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns )
+{
+    dummy_log_trace( MODULENAME, "get_session_info: session_id %s", session_id.c_str() );
+
+    return validate( session_info, session_id, ns, false );
+}
+
+void SessionManager::get_sessions( std::vector<SessionRecord> * sessions, Cursor * cursor, uint32_t max_count )
+{
+    assert( max_count > 0 );
+
+    if( cursor->is_finished )
+        return;
+
+    std::shared_lock<std::shared_timed_mutex> lock( mutex_ );
+
+    auto now = get_now();
+
+    auto sess = cursor->is_started ? table_.upper_bound( cursor->last_session_id ) : table_.get_first();
+
+    uint32_t num = 0;
+
+    for( ; sess != nullptr && num < max_count; sess = table_.get_next( sess ), ++num )
+    {
+        cursor->is_started      = true;
+        cursor->last_session_id = sess->id;
+
+        if( sess->is_expired( now ) )
+            continue;
+
+        SessionRecord r;
+
+        r.session_id = to_string( sess->id );
+
+        fill_session_info( & r.session_info, * sess );
+
+        sessions->push_back( r );
+    }
+
+    if( sess == nullptr )
+        cursor->is_finished = true;
+
+    dummy_log_debug( MODULENAME, "get_sessions: returned %u sessions, finished %u", sessions->size(), cursor->is_finished );
+}
+
+bool SessionManager::import_session( const SessionRecord & r, uint32_t now )
+{
+    SessionId id;
+
+    if( parse_session_id( & id, r.session_id ) == false )
+        return false;
+
+    auto & info = r.session_info;
+
+    auto config = find_config( info.namespace_id );
+
+    if( config == nullptr )
+    {
+        dummy_log_warn( MODULENAME, "import_sessions: session %s: unknown namespace %u", r.session_id.c_str(), info.namespace_id );
+        return false;
+    }
+
+    if( info.attributes.size() > Session::MAX_ATTRIBUTES_SIZE )
+    {
+        dummy_log_warn( MODULENAME, "import_sessions: session %s: attributes are too large: %u", r.session_id.c_str(), info.attributes.size() );
+        return false;
+    }
+
+    auto expire = to_offset( info.expiration_time );
+
+    if( now >= expire || table_.find( id ) )
+        return false;
+
+    if( get_num_user_sessions( info.namespace_id, info.user_id ) >= config->max_sessions_per_user )
+        return false;
+
+    insert_session( id, info.namespace_id, info.user_id, to_offset( info.start_time ), expire, info.attributes );
+
+    return true;
+}
+
+uint32_t SessionManager::import_sessions( const std::vector<SessionRecord> & sessions )
+{
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    auto now = get_now();
+
+    uint32_t num_imported = 0;
+
+    for( std::size_t i = 0; i < sessions.size(); ++i )
+    {
+        // imported sessions never evict the live ones
+        if( is_capacity_exceeded() )
+        {
+            dummy_log_warn( MODULENAME, "import_sessions: capacity exceeded, %u sessions skipped", sessions.size() - i );
+            break;
+        }
+
+        if( import_session( sessions[i], now ) )
+            ++num_imported;
+    }
+
+    dummy_log_debug( MODULENAME, "import_sessions: imported %u of %u sessions", num_imported, sessions.size() );
+
+    return num_imported;
+}
+
+void SessionManager::start_handoff()
+{
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    is_handoff_started_ = true;
+    handoff_start_time_ = get_now();
+
+    handoff_changes_.clear();
+
+    dummy_log_info( MODULENAME, "start_handoff: %u sessions", table_.size() );
+}
+
+void SessionManager::freeze_for_handoff( std::vector<SessionRecord> * sessions, std::vector<std::string> * removed_session_ids )
+{
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    is_frozen_ = true;
+
+    std::vector<SessionId> ids;
+
+    ids.swap( handoff_changes_ );
+
+    if( is_handoff_started_ )
+    {
+        // validators postpone the expiration without the lock, so postponed sessions are not logged,
+        // but found by the expiration time: it was set at or after the start of the handoff
+        for( auto sess = table_.get_first(); sess != nullptr; sess = table_.get_next( sess ) )
+        {
+            auto config = find_config( sess->namespace_id );
+
+            if( config->postpone_expiration && sess->get_expire() >= handoff_start_time_ + config->expiration_time_min * 60 )
+                ids.push_back( sess->id );
+        }
+    }
+
+    is_handoff_started_ = false;
+
+    std::sort( ids.begin(), ids.end() );
+
+    ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+
+    auto now = get_now();
+
+    for( auto & id : ids )
+    {
+        auto sess = table_.find( id );
+
+        if( sess == nullptr )
+        {
+            removed_session_ids->push_back( to_string( id ) );
+            continue;
+        }
+
+        if( sess->is_expired( now ) )
+            continue;
+
+        SessionRecord r;
+
+        r.session_id = to_string( id );
+
+        fill_session_info( & r.session_info, * sess );
+
+        sessions->push_back( r );
+    }
+
+    dummy_log_info( MODULENAME, "freeze_for_handoff: %u changed and %u removed sessions", sessions->size(), removed_session_ids->size() );
+}
+
+void SessionManager::cancel_handoff()
+{
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    is_handoff_started_ = false;
+    is_frozen_          = false;
+
+    handoff_changes_.clear();
+
+    dummy_log_info( MODULENAME, "cancel_handoff: changes are accepted again" );
+}
+
+bool SessionManager::update_session( const SessionRecord & r, uint32_t now )
+{
+    SessionId id;
+
+    if( parse_session_id( & id, r.session_id ) == false )
+        return false;
+
+    auto sess = table_.find( id );
+
+    if( sess == nullptr )
+        return import_session( r, now );
+
+    auto & info = r.session_info;
+
+    if( sess->namespace_id != info.namespace_id || sess->user_id != info.user_id || info.attributes.size() > Session::MAX_ATTRIBUTES_SIZE )
+    {
+        dummy_log_warn( MODULENAME, "import_changes: session %s does not match the existing one", r.session_id.c_str() );
+        return false;
+    }
+
+    if( info.attributes.size() != sess->attributes_size || info.attributes.compare( 0, std::string::npos, sess->get_attributes(), sess->attributes_size ) != 0 )
+    {
+        // the session was already counted by the other manager, so the limit of memory does not apply
+        memory_usage_ += get_session_size( info.attributes.size() );
+        memory_usage_ -= get_session_size( sess->attributes_size );
+
+        sess = table_.set_attributes( id, info.attributes );
+    }
+
+    sess->raise_expire( to_offset( info.expiration_time ) );
+
+    // thread caches hold copies of the attributes and of the expiration time
+    revocation_epoch_.fetch_add( 1, std::memory_order_release );
+
+    return true;
+}
+
+uint32_t SessionManager::import_changes( const std::vector<SessionRecord> & sessions, const std::vector<std::string> & removed_session_ids )
+{
+    std::lock_guard<std::shared_timed_mutex> lock( mutex_ );
+
+    auto now = get_now();
+
+    uint32_t num_applied = 0;
+
+    for( auto & s : removed_session_ids )
+    {
+        SessionId id;
+
+        std::string error;
+
+        if( parse_session_id( & id, s ) && remove_session( id, error ) )
+            ++num_applied;
+    }
+
+    for( auto & r : sessions )
+    {
+        if( update_session( r, now ) )
+            ++num_applied;
+    }
+
+    dummy_log_debug( MODULENAME, "import_changes: applied %u of %u changes", num_applied, sessions.size() + removed_session_ids.size() );
+
+    return num_applied;
+}
+
+void SessionManager::get_user_sessions( std::vector<SessionRecord> * sessions, user_id_t user_id, namespace_id_t ns )
+{
+    std::shared_lock<std::shared_timed_mutex> lock( mutex_ );
+
+    auto now = get_now();
+
+    for( auto sess = table_.get_first_of_user( ns, user_id ); sess != nullptr; sess = table_.get_next_of_user( sess ) )
+    {
+        if( sess->is_expired( now ) )
+            continue;
+
+        SessionRecord r;
+
+        r.session_id = to_string( sess->id );
+
+        fill_session_info( & r.session_info, * sess );
+
+        sessions->push_back( r );
+    }
+}
+
+void SessionManager::update_user_histogram( std::size_t old_num_sessions, std::size_t new_num_sessions )
+{
+    if( old_num_sessions )
+        users_by_num_sessions_[ old_num_sessions ]--;
+
+    if( new_num_sessions )
+    {
+        if( users_by_num_sessions_.size() <= new_num_sessions )
+            users_by_num_sessions_.resize( new_num_sessions + 1, 0 );
+
+        users_by_num_sessions_[ new_num_sessions ]++;
+    }
+}
+
+uint32_t SessionManager::get_sessions_per_user_percentile( uint64_t num_users, double p ) const
+{
+    auto threshold = static_cast<uint64_t>( p / 100.0 * num_users );
+
+    uint64_t num = 0;
+
+    for( std::size_t i = 1; i < users_by_num_sessions_.size(); ++i )
+    {
+        num += users_by_num_sessions_[i];
+
+        if( num > threshold || num == num_users )
+            return static_cast<uint32_t>( i );
+    }
+
+    return 0;
+}
+
+void SessionManager::publish_stats_if_due()
+{
+    auto now = get_now();
+
+    if( now < next_stats_time_.load( std::memory_order_relaxed ) )
+        return;
+
+    std::unique_lock<std::mutex> stats_lock( stats_mutex_, std::try_to_lock );
+
+    if( stats_lock.owns_lock() == false || now < next_stats_time_.load( std::memory_order_relaxed ) )
+        return;     // other thread is publishing
+
+    // called by validators, which must not wait for changes, so publishing is left to a later call
+    std::shared_lock<std::shared_timed_mutex> lock( mutex_, std::try_to_lock );
+
+    if( lock.owns_lock() == false )
+        return;
+
+    next_stats_time_.store( now + std::max( config_.stats_interval_sec, uint16_t( 1 ) ), std::memory_order_relaxed );
+
+    StatsData d;
+
+    d.num_users = table_.get_num_users();
+
+    d.sessions_per_user_p50 = get_sessions_per_user_percentile( d.num_users, 50 );
+    d.sessions_per_user_p90 = get_sessions_per_user_percentile( d.num_users, 90 );
+    d.sessions_per_user_p99 = get_sessions_per_user_percentile( d.num_users, 99 );
+    d.sessions_per_user_max = get_sessions_per_user_percentile( d.num_users, 100 );
+
+    lock.unlock();
+
+    d.update_time               = std::chrono::system_clock::to_time_t( to_time_point( now ) );
+    d.num_sessions              = num_sessions_;
+    d.memory_usage              = memory_usage_;
+    d.num_logins                = num_logins_;
+    d.num_login_failures        = num_login_failures_;
+    d.num_validations           = num_validations_.get();
+    d.num_validation_failures   = num_validation_failures_.get();
+    d.num_expired               = num_expired_;
+    d.num_evicted               = num_evicted_;
+    d.last_reap_duration_us     = last_reap_duration_us_;
+
+    stats_publisher_.publish( d );
+}
+
+void SessionManager::get_stats( Stats * stats ) const
+{
+    stats->num_sessions = num_sessions_;
+    stats->memory_usage = memory_usage_;
+    stats->max_sessions = config_.max_sessions;
+    stats->max_memory   = uint64_t( config_.max_memory_kb ) * 1024;
+
+    stats->num_filter_rejected  = num_filter_rejected_.get();
+    stats->num_filter_passed    = num_filter_passed_.get();
+
+    auto num_unknown = stats->num_filter_rejected + stats->num_filter_passed;
+
+    stats->filter_false_positive_rate   = num_unknown ? double( stats->num_filter_passed ) / num_unknown : 0;
+}
+
+double SessionManager::get_capacity_usage() const
+{
+    double res = 0;
+
+    if( config_.max_sessions )
+        res = std::max( res, double( num_sessions_ ) / config_.max_sessions );
+
+    if( config_.max_memory_kb )
+        res = std::max( res, double( memory_usage_ ) / ( uint64_t( config_.max_memory_kb ) * 1024 ) );
+
+    return res;
+}
+
+SessionManager::Cursor::Cursor():
+        is_started( false ),
+        is_finished( false )
+{
 }
 
 }
@@ -24,80 +24,270 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #ifndef SESSION_MANAGER__MANAGER_H
 #define SESSION_MANAGER__MANAGER_H
 
-#include <map>          // std::map
-#include <set>          // std::set
+#include <vector>       // std::vector
 #include <chrono>       // std::chrono::system_clock::time_point
+#include <atomic>       // std::atomic
+#include <shared_mutex> // std::shared_timed_mutex
 #include <mutex>        // std::mutex
+#include <memory>       // std::unique_ptr
+#include <functional>   // std::function
 
 #include "config.h"     // Config
 #include "types.h"      // user_id_t
+#include "session_id.h" // SessionId
+#include "session_filter.h" // SessionFilter
+#include "session_table.h"  // SessionTable
+#include "stats_publisher.h"    // StatsPublisher
+#include "striped_counter.h"    // StripedCounter
 
 namespace session_manager
 {
 
 class IAuthenticator;
+class IClock;
+class IExecutor;
+struct Credentials;
 
 class SessionManager
 {
 public:
 
+    static const namespace_id_t DEFAULT_NAMESPACE = 0;
+
     struct SessionInfo
     {
+        namespace_id_t                          namespace_id;
         user_id_t                               user_id;
         std::chrono::system_clock::time_point   start_time;
         std::chrono::system_clock::time_point   expiration_time;
+        std::string                             attributes;     // opaque blob set by set_attributes()
+    };
+
+    struct Stats
+    {
+        uint32_t    num_sessions;
+        uint64_t    memory_usage;       // estimated memory used by sessions, in bytes
+        uint32_t    max_sessions;       // 0 - unlimited
+        uint64_t    max_memory;         // in bytes, 0 - unlimited
+
+        uint64_t    num_filter_rejected;    // unknown ids rejected by the filter
+        uint64_t    num_filter_passed;      // unknown ids which passed the filter and were not found in the index
+        double      filter_false_positive_rate;
+    };
+
+    // is_ok, session_id, error
+    typedef std::function<void( bool, const std::string &, const std::string & )>  AuthCallback;
+
+    struct AuthResult
+    {
+        bool            is_ok;
+        std::string     session_id;
+        std::string     error;
+    };
+
+    struct SessionRecord
+    {
+        std::string     session_id;
+        SessionInfo     session_info;
+    };
+
+    // position of the session walk, sessions are walked in the order of their ids, so the walk
+    // can be resumed after sessions were added or removed: each session which exists during the whole walk
+    // is returned exactly once
+    struct Cursor
+    {
+        Cursor();
+
+        bool        is_started;
+        bool        is_finished;
+        SessionId   last_session_id;
     };
 
 public:
     SessionManager();
 
-    void init( IAuthenticator * auth, const Config & config );
+    // clock is optional, the system clock is used if it is not provided,
+    // config is used for the default namespace and for the manager-wide settings (use_thread_cache)
+    void init( IAuthenticator * auth, const Config & config, IClock * clock = nullptr );
 
-    bool authenticate( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error );
-    bool close_session( const std::string & session_id, std::string & error );
+    // namespaces (tenants) share the storage and the reaper, but have own expiration and limits,
+    // sessions of one namespace are not visible in the others
+    void add_namespace( namespace_id_t ns, const Config & config );
 
-    bool is_authenticated( const std::string & session_id );
-    bool get_user_id( user_id_t * user_id, const std::string & session_id );
-    bool get_session_info( SessionInfo * session_info, const std::string & session_id );
+    bool authenticate( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error, namespace_id_t ns = DEFAULT_NAMESPACE );
 
-private:
+    // non-blocking version of authenticate(): the authenticator and the lock are used on the executor,
+    // which also invokes the callback, so the calling thread (e.g. the thread of an event loop) never waits;
+    // the validators (is_authenticated, get_user_id, get_session_info, is_authenticated_batch) take no lock
+    // and can be called from such a thread directly; session_awaitable.h wraps it for C++20 coroutines
+    void authenticate_async( IExecutor * executor, user_id_t user_id, const std::string & password, const AuthCallback & callback, namespace_id_t ns = DEFAULT_NAMESPACE );
+    bool close_session( const std::string & session_id, std::string & error, namespace_id_t ns = DEFAULT_NAMESPACE );
 
-    struct Session
-    {
-        std::chrono::system_clock::time_point started;
-        std::chrono::system_clock::time_point expire;
+    // authenticates many users at once: credentials are verified in parallel outside of the lock,
+    // and all sessions are created in a single critical section; results[i] corresponds to credentials[i]
+    void authenticate_batch( std::vector<AuthResult> * results, const std::vector<Credentials> & credentials, namespace_id_t ns = DEFAULT_NAMESPACE );
 
-        bool is_expired() const;
-    };
+    // stores an opaque attribute blob (roles, tenant, CSRF token, ...) of up to 65535 bytes with the session,
+    // it is kept in the session record, returned by get_session_info() and freed together with the session
+    bool set_attributes( const std::string & session_id, const std::string & attributes, std::string & error, namespace_id_t ns = DEFAULT_NAMESPACE );
+
+    bool is_authenticated( const std::string & session_id, namespace_id_t ns = DEFAULT_NAMESPACE );
+    bool get_user_id( user_id_t * user_id, const std::string & session_id, namespace_id_t ns = DEFAULT_NAMESPACE );
+    bool get_session_info( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns = DEFAULT_NAMESPACE );
+
+    // validates many sessions at once, ids which miss the thread cache and the filter are looked up
+    // in a single critical section; results[i] and user_ids[i] (optional) correspond to session_ids[i]
+    void is_authenticated_batch( std::vector<uint8_t> * results, std::vector<user_id_t> * user_ids, const std::vector<std::string> & session_ids, namespace_id_t ns = DEFAULT_NAMESPACE );
+
+    // returns up to max_count sessions of all namespaces starting from the cursor position, the lock is held only for one chunk
+    void get_sessions( std::vector<SessionRecord> * sessions, Cursor * cursor, uint32_t max_count );
+    void get_user_sessions( std::vector<SessionRecord> * sessions, user_id_t user_id, namespace_id_t ns = DEFAULT_NAMESPACE );
+
+    // adds sessions obtained by get_sessions() of another manager, e.g. during a process upgrade;
+    // expired, already existing sessions, sessions of unknown namespaces and sessions above the limits are skipped
+    uint32_t import_sessions( const std::vector<SessionRecord> & sessions );
+
+    // handoff to another manager, see session_handoff.h: from now on the sessions created, changed or removed
+    // by writers are logged, so that the changes behind the cursor of get_sessions() are not lost
+    void start_handoff();
+
+    // cutover of the handoff: all further changes (logins, closes, set_attributes) are rejected,
+    // validations are still served; returns the sessions which were created, changed or postponed
+    // since start_handoff() and the ids of the removed ones
+    void freeze_for_handoff( std::vector<SessionRecord> * sessions, std::vector<std::string> * removed_session_ids );
+
+    // the handoff failed, changes are accepted again
+    void cancel_handoff();
+
+    // applies the changes returned by freeze_for_handoff() of another manager: the records replace
+    // the existing sessions or are imported, the removed sessions are closed; returns the number of applied changes
+    uint32_t import_changes( const std::vector<SessionRecord> & sessions, const std::vector<std::string> & removed_session_ids );
 
-    typedef std::map<std::string,Session>       MapSessionIdToSession;
-    typedef std::map<std::string,user_id_t>     MapSessionIdToUser;
+    // lock-free, can be polled frequently, e.g. by health checks of a load balancer
+    void get_stats( Stats * stats ) const;
 
-    typedef std::map<user_id_t,std::set<std::string>>    MapUserToSessionList;
+    // used fraction of the global capacity (the larger one of sessions and memory), 0 if unlimited
+    double get_capacity_usage() const;
 
 private:
 
-    void remove_expired();
+    static void check_config( const Config & config );
+
+    const Config * find_config( namespace_id_t ns ) const;
+    void publish_config( namespace_id_t ns, const Config & config );
+
+    // sessions are reaped lazily by a walk over the table, which wraps around and resumes where it stopped,
+    // the work per call is bounded by the number of visited sessions
+    void remove_expired( std::size_t max_visited );
+    void remove_expired_on_overflow();
+    void remove_expired( namespace_id_t ns, user_id_t user_id );
+
+    Session * get_reaper_start() const;
+    Session * get_reaper_next( const Session * sess ) const;
+
+    bool authenticate_impl( user_id_t user_id, const std::string & password, std::string & session_id, std::string & error, namespace_id_t ns );
+    bool call_authenticator( user_id_t user_id, const std::string & password );
+    bool create_session( const Config & config, namespace_id_t ns, user_id_t user_id, std::string & session_id, std::string & error );
+
+    bool is_capacity_exceeded() const;
+    bool is_capacity_exceeded_after_reaping();
+    bool evict_session();
+
+    static std::size_t get_session_size( std::size_t attributes_size );
+
+    uint32_t get_now() const;
+    std::chrono::system_clock::time_point to_time_point( uint32_t t ) const;
+    uint32_t to_offset( const std::chrono::system_clock::time_point & t ) const;
 
-    void init_new_session( Session & sess );
     void postpone_expiration( Session & sess );
 
-    void add_new_session( MapUserToSessionList::mapped_type & sess_set, user_id_t user_id, std::string & session_id );
+    void add_new_session( const Config & config, namespace_id_t ns, user_id_t user_id, std::string & session_id );
 
-    bool remove_session( const std::string & session_id, std::string & error );
-    bool get_associated_session( SessionInfo * session_info, const std::string & session_id, bool is_user_request );
+    void insert_session( const SessionId & id, namespace_id_t ns, user_id_t user_id, uint32_t started, uint32_t expire, const std::string & attributes );
+
+    std::size_t get_num_user_sessions( namespace_id_t ns, user_id_t user_id ) const;
+
+    bool remove_session( const SessionId & session_id, std::string & error );
+    bool import_session( const SessionRecord & record, uint32_t now );
+    bool update_session( const SessionRecord & record, uint32_t now );
+    void fill_session_info( SessionInfo * session_info, const Session & session ) const;
+    bool get_associated_session( SessionInfo * session_info, const SessionId & session_id, namespace_id_t ns, bool is_user_request );
+    void count_filter_miss( const SessionId & session_id );
+    bool validate( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns, bool is_user_request );
+    bool validate_impl( SessionInfo * session_info, const std::string & session_id, namespace_id_t ns, bool is_user_request );
+
+    void update_user_histogram( std::size_t old_num_sessions, std::size_t new_num_sessions );
+    uint32_t get_sessions_per_user_percentile( uint64_t num_users, double p ) const;
+    void publish_stats_if_due();
+
+    bool find_in_thread_cache( SessionInfo * session_info, const SessionId & session_id, namespace_id_t ns, bool is_user_request ) const;
+    void add_to_thread_cache( const SessionInfo & session_info, const SessionId & session_id, uint64_t epoch ) const;
 
 private:
-    mutable std::mutex      mutex_;
+    const uint32_t          instance_id_;       // distinguishes entries of different managers in the thread cache
+
+    // bumped on every session removal, invalidates all thread caches; read by every validation, so it takes
+    // its own cache line and the writes of the neighbours do not evict it from the caches of the validators
+    alignas( 64 ) std::atomic<uint64_t>     revocation_epoch_;
+
+    // changed under the exclusive lock, but read without the lock
+    alignas( 64 ) std::atomic<uint32_t>     num_sessions_;
+    std::atomic<uint64_t>   memory_usage_;
 
+    SessionFilter           filter_;
+
+    // incremented by validators of unknown ids
+    StripedCounter          num_filter_rejected_;
+    StripedCounter          num_filter_passed_;
+
+    // counters of the stats page, maintained only if it is enabled
+    StatsPublisher          stats_publisher_;
+    std::mutex              stats_mutex_;       // serializes publishing
+    std::atomic<uint32_t>   next_stats_time_;   // seconds relative to epoch_
+    std::atomic<uint64_t>   num_logins_;
+    std::atomic<uint64_t>   num_login_failures_;
+    StripedCounter          num_validations_;           // incremented by every validator
+    StripedCounter          num_validation_failures_;
+    std::atomic<uint64_t>   num_expired_;
+    std::atomic<uint64_t>   num_evicted_;
+    std::atomic<uint64_t>   last_reap_duration_us_;
+
+    // exclusive lock serializes changes, shared lock protects enumeration from them; validation takes no lock
+    mutable std::shared_timed_mutex     mutex_;
 
     IAuthenticator          * auth_;
+    IClock                  * clock_;
+
+    std::mutex              auth_mutex_;        // serializes calls of an authenticator which is not thread-safe
+
+    Config                  config_;    // config passed to init()
+
+    // namespace id -> config, two levels of atomically published blocks, so that lock-free readers never see
+    // a reallocation; configs are immutable and freed only with the manager
+    struct ConfigBlock
+    {
+        std::atomic<const Config*>  configs[ 256 ];
+    };
+
+    std::atomic<ConfigBlock*>                   config_blocks_[ 256 ];
+    std::vector<std::unique_ptr<ConfigBlock>>   config_block_storage_;
+    std::vector<std::unique_ptr<Config>>        config_storage_;
+
+    std::chrono::system_clock::time_point   epoch_;
+
+    SessionTable            table_;
+
+    bool                    is_reaper_started_;
+    SessionId               reaper_position_;   // last session visited by the reaper
+    uint32_t                last_overflow_reap_time_;
 
-    Config                  config_;
+    // handoff to another manager, changed under the exclusive lock
+    bool                    is_handoff_started_;
+    bool                    is_frozen_;             // changes are rejected after the cutover
+    uint32_t                handoff_start_time_;
+    std::vector<SessionId>  handoff_changes_;       // sessions created, changed or removed since the start
 
-    MapSessionIdToSession   map_sessions_;
-    MapUserToSessionList    map_user_to_sessions_;
-    MapSessionIdToUser      map_session_to_user_;
+    std::vector<uint64_t>   users_by_num_sessions_;     // number of sessions -> number of users
 };
 
 }
@@ -0,0 +1,813 @@
+/*
+
+Session Manager - Session Table.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "session_table.h"      // self
+
+#include <cassert>              // assert
+#include <cstring>              // memcpy
+#include <cstdlib>              // calloc, free
+#include <new>                  // placement new, std::bad_alloc
+
+#define INITIAL_BUCKET_BITS     4
+#define NUM_READER_SLOTS        128     // threads beyond it share slots, which is correct, but slower
+#define CACHE_LINE_SIZE         64
+#define RECLAIM_THRESHOLD       64      // number of retired records which triggers an attempt to free them
+#define MAX_LOAD_FACTOR         2       // average number of records per bucket which triggers the doubling
+
+namespace session_manager
+{
+
+namespace
+{
+
+std::atomic<uint32_t>   last_reader_index( 0 );
+
+thread_local uint32_t   reader_index    = last_reader_index++;
+
+// bytes of the id at the given offset as a big-endian number
+uint64_t load_half( const SessionId & id, std::size_t offset )
+{
+#if defined( __GNUC__ ) && defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+    uint64_t res;
+
+    memcpy( & res, id.data + offset, sizeof( res ) );
+
+    return __builtin_bswap64( res );
+#else
+    uint64_t res = 0;
+
+    for( std::size_t i = 0; i < sizeof( res ); ++i )
+        res = ( res << 8 ) | id.data[ offset + i ];
+
+    return res;
+#endif
+}
+
+// three-way comparison in the order of bytes; the ids come from clients, so the time must not depend on
+// the position of the first differing byte: both halves are compared and combined without a branch
+int compare( const SessionId & l, const SessionId & r )
+{
+    auto lh = load_half( l, 0 );
+    auto rh = load_half( r, 0 );
+    auto ll = load_half( l, 8 );
+    auto rl = load_half( r, 8 );
+
+    int high    = int( lh > rh ) - int( lh < rh );
+    int low     = int( ll > rl ) - int( ll < rl );
+
+    // the low half decides only if the high halves are equal
+    return high | ( low & -int( high == 0 ) );
+}
+
+uint64_t reverse_bits( uint64_t v )
+{
+    v = ( ( v >> 1 ) & 0x5555555555555555ULL ) | ( ( v & 0x5555555555555555ULL ) << 1 );
+    v = ( ( v >> 2 ) & 0x3333333333333333ULL ) | ( ( v & 0x3333333333333333ULL ) << 2 );
+    v = ( ( v >> 4 ) & 0x0F0F0F0F0F0F0F0FULL ) | ( ( v & 0x0F0F0F0F0F0F0F0FULL ) << 4 );
+    v = ( ( v >> 8 ) & 0x00FF00FF00FF00FFULL ) | ( ( v & 0x00FF00FF00FF00FFULL ) << 8 );
+    v = ( ( v >> 16 ) & 0x0000FFFF0000FFFFULL ) | ( ( v & 0x0000FFFF0000FFFFULL ) << 16 );
+
+    return ( v >> 32 ) | ( v << 32 );
+}
+
+// index of the highest set bit, v must not be 0
+uint32_t get_highest_bit( uint64_t v )
+{
+#if defined( __GNUC__ )
+    return 63 - __builtin_clzll( v );
+#else
+    uint32_t res = 0;
+
+    while( v >>= 1 )
+        ++res;
+
+    return res;
+#endif
+}
+
+// first 4 bytes of the id as a big-endian number, the key of the sentinels
+uint32_t get_key( const SessionId & id )
+{
+    return static_cast<uint32_t>( load_half( id, 0 ) >> 32 );
+}
+
+// bucket of the id of num_buckets, which is a power of 2
+std::size_t get_bucket_index( const SessionId & id, std::size_t num_buckets )
+{
+    return static_cast<std::size_t>( reverse_bits( load_half( id, 0 ) ) & ( num_buckets - 1 ) );
+}
+
+std::size_t get_parent( std::size_t bucket )
+{
+    return bucket & ~( std::size_t( 1 ) << get_highest_bit( bucket ) );
+}
+
+uint32_t to_link( uint32_t index, bool is_sentinel )
+{
+    return ( index << 1 ) | ( is_sentinel ? 1 : 0 );
+}
+
+uint32_t to_index( uint32_t link )
+{
+    return link >> 1;
+}
+
+bool is_sentinel( uint32_t link )
+{
+    return ( link & 1 ) != 0;
+}
+
+// user ids are often sequential, so they are mixed (finalizer of MurmurHash3) before the bits are used as a bucket
+uint64_t hash_user( namespace_id_t namespace_id, user_id_t user_id )
+{
+    uint64_t h = ( uint64_t( namespace_id ) << 32 ) | user_id;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+}
+
+Session::Session( const SessionId & id, namespace_id_t namespace_id, user_id_t user_id, uint32_t started, uint32_t expire, uint16_t attributes_size ):
+        next_of_user( RecordArena::NULL_INDEX ),
+        id( id ),
+        user_id( user_id ),
+        started( started ),
+        expire( expire ),
+        namespace_id( namespace_id ),
+        attributes_size( attributes_size )
+{
+    next.store( 0, std::memory_order_relaxed );
+}
+
+bool Session::is_expired( uint32_t now ) const
+{
+    return ( now >= get_expire() ) ? true : false;
+}
+
+uint32_t Session::get_expire() const
+{
+    return expire.load( std::memory_order_relaxed ) & ~REPLACED;
+}
+
+bool Session::postpone( uint32_t value )
+{
+    // acquire pairs with set_attributes(): a reader which sees the flag finds the replacement in the table
+    auto cur = expire.load( std::memory_order_acquire );
+
+    do
+    {
+        if( cur & REPLACED )
+            return false;
+    }
+    while( expire.compare_exchange_weak( cur, value, std::memory_order_acquire ) == false );
+
+    return true;
+}
+
+void Session::raise_expire( uint32_t value )
+{
+    auto cur = expire.load( std::memory_order_relaxed );
+
+    while( ( cur & ~REPLACED ) < value && expire.compare_exchange_weak( cur, ( cur & REPLACED ) | value, std::memory_order_relaxed ) == false )
+    {
+    }
+}
+
+const char * Session::get_attributes() const
+{
+    return reinterpret_cast<const char*>( this + 1 );
+}
+
+SessionTable::ReadGuard::ReadGuard( const SessionTable & table )
+{
+    auto & slot = table.get_reader_slot();
+
+    // the counter is incremented before the epoch is confirmed, so that the writer either sees the reader
+    // or the reader sees the new epoch and moves to the counter of its parity
+    while( true )
+    {
+        auto epoch = table.epoch_.load( std::memory_order_seq_cst );
+
+        counter_ = & slot.counters[ epoch & 1 ];
+
+        counter_->fetch_add( 1, std::memory_order_seq_cst );
+
+        if( table.epoch_.load( std::memory_order_seq_cst ) == epoch )
+            break;
+
+        counter_->fetch_sub( 1, std::memory_order_release );
+    }
+}
+
+SessionTable::ReadGuard::~ReadGuard()
+{
+    counter_->fetch_sub( 1, std::memory_order_release );
+}
+
+SessionTable::SessionTable():
+        num_buckets_( std::size_t( 1 ) << INITIAL_BUCKET_BITS ),
+        split_index_( 0 ),
+        size_( 0 ),
+        user_level_( INITIAL_BUCKET_BITS ),
+        user_split_( 0 ),
+        num_users_( 0 ),
+        segment_memory_( 0 ),
+        epoch_( 0 ),
+        reader_slots_buffer_( new char[ ( NUM_READER_SLOTS + 1 ) * CACHE_LINE_SIZE ] )
+{
+    static_assert( sizeof( ReaderSlot ) == CACHE_LINE_SIZE, "reader slot must take one cache line" );
+    static_assert( sizeof( Session ) == 40 && alignof( Session ) <= RecordArena::UNIT_SIZE, "unexpected layout of the session record" );
+    static_assert( sizeof( Sentinel ) == RecordArena::UNIT_SIZE, "sentinel must take one unit of the arena" );
+
+    auto p = reinterpret_cast<uintptr_t>( reader_slots_buffer_.get() );
+
+    p = ( p + CACHE_LINE_SIZE - 1 ) & ~uintptr_t( CACHE_LINE_SIZE - 1 );
+
+    reader_slots_ = reinterpret_cast<ReaderSlot*>( p );
+
+    for( uint32_t i = 0; i < NUM_READER_SLOTS; ++i )
+        new( & reader_slots_[i] ) ReaderSlot();
+
+    for( auto & s : segments_ )
+        s.store( nullptr, std::memory_order_relaxed );
+
+    for( auto & s : user_segments_ )
+        s = nullptr;
+
+    user_segments_[0] = static_cast<uint32_t*>( calloc( get_segment_size( 0 ), sizeof( uint32_t ) ) );
+
+    if( user_segments_[0] == nullptr )
+        throw std::bad_alloc();
+
+    segment_memory_ += get_segment_size( 0 ) * sizeof( uint32_t );
+
+    // bucket 0 is the head of the list
+    init_bucket( 0 );
+}
+
+SessionTable::~SessionTable()
+{
+    // no readers are active anymore, the records are freed with the arena
+
+    for( auto & s : segments_ )
+        free( s.load( std::memory_order_relaxed ) );
+
+    for( auto s : user_segments_ )
+        free( s );
+}
+
+std::size_t SessionTable::get_session_memory( std::size_t attributes_size )
+{
+    // the record with its attributes; right after a doubling the list has one bucket, i.e. a slot
+    // and a sentinel, per record; the user index has a bucket head per two records, but its segments
+    // are allocated up to twice ahead
+    return get_num_units( attributes_size ) * RecordArena::UNIT_SIZE
+            + sizeof( Bucket ) + sizeof( Sentinel )
+            + sizeof( uint32_t );
+}
+
+std::size_t SessionTable::get_segment_index( std::size_t bucket )
+{
+    if( bucket < ( std::size_t( 1 ) << INITIAL_BUCKET_BITS ) )
+        return 0;
+
+    return get_highest_bit( bucket ) - INITIAL_BUCKET_BITS + 1;
+}
+
+std::size_t SessionTable::get_segment_begin( std::size_t segment_index )
+{
+    return segment_index ? ( std::size_t( 1 ) << ( INITIAL_BUCKET_BITS + segment_index - 1 ) ) : 0;
+}
+
+std::size_t SessionTable::get_segment_size( std::size_t segment_index )
+{
+    return std::size_t( 1 ) << ( segment_index ? INITIAL_BUCKET_BITS + segment_index - 1 : INITIAL_BUCKET_BITS );
+}
+
+uint32_t SessionTable::get_num_units( std::size_t attributes_size )
+{
+    return RecordArena::get_num_units( sizeof( Session ) + attributes_size );
+}
+
+ListNode * SessionTable::get_node( uint32_t link ) const
+{
+    return static_cast<ListNode*>( arena_.get( to_index( link ) ) );
+}
+
+Session * SessionTable::get_session( uint32_t index ) const
+{
+    return static_cast<Session*>( arena_.get( index ) );
+}
+
+uint32_t SessionTable::get_bucket( std::size_t bucket ) const
+{
+    auto i = get_segment_index( bucket );
+
+    auto segment = segments_[i].load( std::memory_order_acquire );
+
+    if( segment == nullptr )
+        return RecordArena::NULL_INDEX;
+
+    return segment[ bucket - get_segment_begin( i ) ].load( std::memory_order_acquire );
+}
+
+ListNode * SessionTable::find_bucket( const SessionId & id ) const
+{
+    // a stale number of buckets only makes the walk longer
+    auto bucket = get_bucket_index( id, num_buckets_.load( std::memory_order_acquire ) );
+
+    while( true )
+    {
+        auto res = get_bucket( bucket );
+
+        if( res != RecordArena::NULL_INDEX )
+            return static_cast<ListNode*>( arena_.get( res ) );
+
+        bucket = get_parent( bucket );
+    }
+}
+
+bool SessionTable::is_before( uint32_t link, const SessionId & id ) const
+{
+    auto node = get_node( link );
+
+    // a sentinel precedes the ids with the same first bytes
+    if( is_sentinel( link ) )
+        return static_cast<const Sentinel*>( node )->key <= get_key( id );
+
+    return compare( static_cast<const Session*>( node )->id, id ) < 0;
+}
+
+uint32_t SessionTable::init_bucket( std::size_t bucket )
+{
+    auto res = get_bucket( bucket );
+
+    if( res != RecordArena::NULL_INDEX )
+        return res;
+
+    // at most 2^32 buckets, so the key takes the first 32 bits of the reversed bucket number
+    auto key = static_cast<uint32_t>( reverse_bits( bucket ) >> 32 );
+
+    // the range of the bucket is the upper half of the range of its parent
+    std::atomic<uint32_t> * link = nullptr;
+
+    if( bucket )
+    {
+        link = & static_cast<ListNode*>( arena_.get( init_bucket( get_parent( bucket ) ) ) )->next;
+
+        while( true )
+        {
+            auto next = link->load( std::memory_order_relaxed );
+
+            if( next == 0 )
+                break;
+
+            auto node = get_node( next );
+
+            if( is_sentinel( next ) ? static_cast<Sentinel*>( node )->key >= key : get_key( static_cast<Session*>( node )->id ) >= key )
+                break;
+
+            link = & node->next;
+        }
+    }
+
+    res = arena_.allocate( 1 );
+
+    auto sentinel = new( arena_.get( res ) ) Sentinel;
+
+    sentinel->key = key;
+    sentinel->next.store( link ? link->load( std::memory_order_relaxed ) : 0, std::memory_order_relaxed );
+
+    if( link )
+        link->store( to_link( res, true ), std::memory_order_release );
+
+    auto i = get_segment_index( bucket );
+
+    auto segment = segments_[i].load( std::memory_order_relaxed );
+
+    if( segment == nullptr )
+    {
+        // calloc, so that the pages of a large segment are zeroed lazily by the system, not by the writer
+        segment = static_cast<Bucket*>( calloc( get_segment_size( i ), sizeof( Bucket ) ) );
+
+        if( segment == nullptr )
+            throw std::bad_alloc();
+
+        segment_memory_ += get_segment_size( i ) * sizeof( Bucket );
+
+        segments_[i].store( segment, std::memory_order_release );
+    }
+
+    // the sentinel is linked before it is published as the start of lookups
+    segment[ bucket - get_segment_begin( i ) ].store( res, std::memory_order_release );
+
+    return res;
+}
+
+SessionTable::ReaderSlot & SessionTable::get_reader_slot() const
+{
+    return reader_slots_[ reader_index % NUM_READER_SLOTS ];
+}
+
+Session * SessionTable::find( const SessionId & id ) const
+{
+    auto key = get_key( id );
+
+    auto link = find_bucket( id )->next.load( std::memory_order_acquire );
+
+    while( link )
+    {
+        auto node = get_node( link );
+
+        if( is_sentinel( link ) )
+        {
+            if( static_cast<const Sentinel*>( node )->key > key )
+                return nullptr;
+        }
+        else
+        {
+            auto c = compare( static_cast<const Session*>( node )->id, id );
+
+            if( c == 0 )
+                return static_cast<Session*>( node );
+
+            if( c > 0 )
+                return nullptr;
+        }
+
+        link = node->next.load( std::memory_order_acquire );
+    }
+
+    return nullptr;
+}
+
+std::atomic<uint32_t> * SessionTable::find_link( const SessionId & id ) const
+{
+    auto link = & find_bucket( id )->next;
+
+    while( true )
+    {
+        auto next = link->load( std::memory_order_relaxed );
+
+        if( next == 0 || is_before( next, id ) == false )
+            return link;
+
+        link = & get_node( next )->next;
+    }
+}
+
+Session * SessionTable::insert( const SessionId & id, namespace_id_t namespace_id, user_id_t user_id, uint32_t started, uint32_t expire, const std::string & attributes )
+{
+    assert( attributes.size() <= Session::MAX_ATTRIBUTES_SIZE );
+
+    auto num_buckets = num_buckets_.load( std::memory_order_relaxed );
+
+    if( size_ >= num_buckets * MAX_LOAD_FACTOR && get_segment_index( num_buckets ) < NUM_SEGMENTS )
+    {
+        num_buckets *= 2;
+
+        num_buckets_.store( num_buckets, std::memory_order_release );
+    }
+
+    // one bucket per insert, so all buckets are initialized long before the next doubling
+    if( split_index_ < num_buckets )
+        init_bucket( split_index_++ );
+
+    init_bucket( get_bucket_index( id, num_buckets ) );
+
+    // the user index grows at the same pace, by one bucket per insert
+    if( ( ( std::size_t( 1 ) << user_level_ ) + user_split_ ) * MAX_LOAD_FACTOR < size_ )
+        split_user_bucket();
+
+    auto index = arena_.allocate( get_num_units( attributes.size() ) );
+
+    auto session = new( arena_.get( index ) ) Session( id, namespace_id, user_id, started, expire, static_cast<uint16_t>( attributes.size() ) );
+
+    memcpy( reinterpret_cast<char*>( session + 1 ), attributes.data(), attributes.size() );
+
+    auto link = find_link( id );
+
+    auto next = link->load( std::memory_order_relaxed );
+
+    assert( next == 0 || is_sentinel( next ) || compare( static_cast<Session*>( get_node( next ) )->id, id ) != 0 );
+
+    session->next.store( next, std::memory_order_relaxed );
+
+    // the record is fully constructed before it becomes visible
+    link->store( to_link( index, false ), std::memory_order_release );
+
+    link_to_user( index );
+
+    ++size_;
+
+    return session;
+}
+
+Session * SessionTable::set_attributes( const SessionId & id, const std::string & attributes )
+{
+    assert( attributes.size() <= Session::MAX_ATTRIBUTES_SIZE );
+
+    auto link = find_link( id );
+
+    auto next = link->load( std::memory_order_relaxed );
+
+    if( next == 0 || is_sentinel( next ) || compare( static_cast<Session*>( get_node( next ) )->id, id ) != 0 )
+        return nullptr;
+
+    auto old_index = to_index( next );
+
+    auto p = get_session( old_index );
+
+    auto index = arena_.allocate( get_num_units( attributes.size() ) );
+
+    auto session = new( arena_.get( index ) ) Session( id, p->namespace_id, p->user_id, p->started, p->get_expire(), static_cast<uint16_t>( attributes.size() ) );
+
+    memcpy( reinterpret_cast<char*>( session + 1 ), attributes.data(), attributes.size() );
+
+    session->next.store( p->next.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+
+    link->store( to_link( index, false ), std::memory_order_release );
+
+    // postponements of the old record which happened until now are carried over, the later ones see the flag
+    // and go to the replacement
+    auto expire = p->expire.fetch_or( Session::REPLACED, std::memory_order_acq_rel );
+
+    session->raise_expire( expire & ~Session::REPLACED );
+
+    // the replacement takes the place of the old record in the chain of the user
+    auto user_link = find_user_link( old_index );
+
+    session->next_of_user   = p->next_of_user;
+    * user_link             = index;
+
+    retire( old_index );
+
+    return session;
+}
+
+bool SessionTable::erase( const SessionId & id )
+{
+    auto link = find_link( id );
+
+    auto next = link->load( std::memory_order_relaxed );
+
+    if( next == 0 || is_sentinel( next ) || compare( static_cast<Session*>( get_node( next ) )->id, id ) != 0 )
+        return false;
+
+    auto index = to_index( next );
+
+    // the next link of the removed record is kept, so that readers standing on it can continue
+    link->store( get_session( index )->next.load( std::memory_order_relaxed ), std::memory_order_release );
+
+    unlink_from_user( index );
+
+    retire( index );
+
+    --size_;
+
+    return true;
+}
+
+Session * SessionTable::get_first() const
+{
+    return get_next( static_cast<const ListNode*>( arena_.get( get_bucket( 0 ) ) ) );
+}
+
+Session * SessionTable::get_next( const ListNode * node ) const
+{
+    auto link = node->next.load( std::memory_order_relaxed );
+
+    while( is_sentinel( link ) )
+        link = get_node( link )->next.load( std::memory_order_relaxed );
+
+    return link ? get_session( to_index( link ) ) : nullptr;
+}
+
+Session * SessionTable::upper_bound( const SessionId & id ) const
+{
+    auto link = find_link( id );
+
+    // the link is the first member of its node
+    auto res = get_next( reinterpret_cast<const ListNode*>( link ) );
+
+    if( res && compare( res->id, id ) == 0 )
+        res = get_next( res );
+
+    return res;
+}
+
+std::size_t SessionTable::get_user_bucket( namespace_id_t namespace_id, user_id_t user_id ) const
+{
+    auto h = hash_user( namespace_id, user_id );
+
+    // linear hashing: the buckets before the split pointer were already split into the next level
+    auto res = static_cast<std::size_t>( h & ( ( std::size_t( 1 ) << user_level_ ) - 1 ) );
+
+    if( res < user_split_ )
+        res = static_cast<std::size_t>( h & ( ( std::size_t( 1 ) << ( user_level_ + 1 ) ) - 1 ) );
+
+    return res;
+}
+
+uint32_t * SessionTable::get_user_head( std::size_t bucket ) const
+{
+    auto i = get_segment_index( bucket );
+
+    return & user_segments_[i][ bucket - get_segment_begin( i ) ];
+}
+
+Session * SessionTable::find_of_user( uint32_t index, namespace_id_t namespace_id, user_id_t user_id ) const
+{
+    while( index != RecordArena::NULL_INDEX )
+    {
+        auto s = get_session( index );
+
+        if( s->user_id == user_id && s->namespace_id == namespace_id )
+            return s;
+
+        index = s->next_of_user;
+    }
+
+    return nullptr;
+}
+
+uint32_t * SessionTable::find_user_link( uint32_t index ) const
+{
+    auto s = get_session( index );
+
+    auto link = get_user_head( get_user_bucket( s->namespace_id, s->user_id ) );
+
+    while( * link != index )
+    {
+        assert( * link != RecordArena::NULL_INDEX );
+
+        link = & get_session( * link )->next_of_user;
+    }
+
+    return link;
+}
+
+void SessionTable::link_to_user( uint32_t index )
+{
+    auto s = get_session( index );
+
+    auto head = get_user_head( get_user_bucket( s->namespace_id, s->user_id ) );
+
+    if( find_of_user( * head, s->namespace_id, s->user_id ) == nullptr )
+        ++num_users_;
+
+    s->next_of_user = * head;
+    * head          = index;
+}
+
+void SessionTable::unlink_from_user( uint32_t index )
+{
+    auto s = get_session( index );
+
+    * find_user_link( index ) = s->next_of_user;
+
+    if( get_first_of_user( s->namespace_id, s->user_id ) == nullptr )
+        --num_users_;
+}
+
+void SessionTable::split_user_bucket()
+{
+    auto num = std::size_t( 1 ) << user_level_;
+
+    auto to = user_split_ + num;
+
+    auto i = get_segment_index( to );
+
+    if( i >= NUM_SEGMENTS )
+        return;
+
+    if( user_segments_[i] == nullptr )
+    {
+        user_segments_[i] = static_cast<uint32_t*>( calloc( get_segment_size( i ), sizeof( uint32_t ) ) );
+
+        if( user_segments_[i] == nullptr )
+            throw std::bad_alloc();
+
+        segment_memory_ += get_segment_size( i ) * sizeof( uint32_t );
+    }
+
+    // the sessions of the bucket which belong to the new one at the next level are moved there
+    auto mask       = ( num << 1 ) - 1;
+    auto link       = get_user_head( user_split_ );
+    auto to_head    = get_user_head( to );
+
+    while( * link != RecordArena::NULL_INDEX )
+    {
+        auto index  = * link;
+        auto s      = get_session( index );
+
+        if( ( hash_user( s->namespace_id, s->user_id ) & mask ) == to )
+        {
+            * link          = s->next_of_user;
+            s->next_of_user = * to_head;
+            * to_head       = index;
+        }
+        else
+        {
+            link = & s->next_of_user;
+        }
+    }
+
+    if( ++user_split_ == num )
+    {
+        user_split_ = 0;
+        ++user_level_;
+    }
+}
+
+Session * SessionTable::get_first_of_user( namespace_id_t namespace_id, user_id_t user_id ) const
+{
+    return find_of_user( * get_user_head( get_user_bucket( namespace_id, user_id ) ), namespace_id, user_id );
+}
+
+Session * SessionTable::get_next_of_user( const Session * session ) const
+{
+    return find_of_user( session->next_of_user, session->namespace_id, session->user_id );
+}
+
+std::size_t SessionTable::size() const
+{
+    return size_;
+}
+
+std::size_t SessionTable::get_num_users() const
+{
+    return num_users_;
+}
+
+std::size_t SessionTable::get_memory() const
+{
+    return arena_.get_memory() + segment_memory_;
+}
+
+void SessionTable::retire( uint32_t index )
+{
+    retired_sessions_[ epoch_.load( std::memory_order_relaxed ) & 1 ].push_back( index );
+
+    try_reclaim();
+}
+
+void SessionTable::try_reclaim()
+{
+    auto epoch = epoch_.load( std::memory_order_relaxed );
+
+    auto & retired = retired_sessions_[ epoch & 1 ];
+
+    if( retired.size() < RECLAIM_THRESHOLD )
+        return;
+
+    // records retired in the previous epoch are safe to free when no reader of that epoch is active:
+    // readers entering the current epoch cannot reach them anymore
+    auto previous = ( epoch + 1 ) & 1;
+
+    for( uint32_t i = 0; i < NUM_READER_SLOTS; ++i )
+    {
+        if( reader_slots_[i].counters[ previous ].load( std::memory_order_seq_cst ) != 0 )
+            return;
+    }
+
+    free_retired( previous );
+
+    epoch_.store( epoch + 1, std::memory_order_seq_cst );
+}
+
+void SessionTable::free_retired( uint32_t parity )
+{
+    for( auto index : retired_sessions_[ parity ] )
+        arena_.free( index, get_num_units( get_session( index )->attributes_size ) );
+
+    retired_sessions_[ parity ].clear();
+}
+
+} // namespace session_manager
@@ -0,0 +1,250 @@
+/*
+
+Session Manager - Session Table.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__SESSION_TABLE_H
+#define SESSION_MANAGER__SESSION_TABLE_H
+
+#include <atomic>       // std::atomic
+#include <cstdint>      // uint32_t
+#include <memory>       // std::unique_ptr
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#include "types.h"      // user_id_t
+#include "session_id.h" // SessionId
+#include "record_arena.h"   // RecordArena
+
+namespace session_manager
+{
+
+// link of the list of the table: arena index of the next node shifted left by one,
+// the lowest bit is set in links to bucket sentinels, 0 - end of the list
+struct ListNode
+{
+    std::atomic<uint32_t>   next;
+};
+
+// compact session record in the arena of the table, the times are stored in seconds relative to the epoch
+// of the manager; a record is immutable while it is in the table, except of expire (postponed by readers)
+// and the links. A replaced record gets the REPLACED flag in expire, so that a reader which still holds it
+// postpones the replacement.
+//
+// The attributes follow the record in the same block, so a session without attributes costs sizeof( Session ) only
+// and a session with attributes needs neither a second allocation nor a second lookup.
+struct Session: ListNode
+{
+    static const std::size_t MAX_ATTRIBUTES_SIZE = 0xFFFF;
+
+    static const uint32_t REPLACED              = 0x80000000;
+
+    uint32_t                next_of_user;       // arena index of the next session in the chain of the user bucket
+    SessionId               id;
+    user_id_t               user_id;
+    uint32_t                started;
+    std::atomic<uint32_t>   expire;
+    namespace_id_t          namespace_id;
+    uint16_t                attributes_size;
+
+    Session( const SessionId & id, namespace_id_t namespace_id, user_id_t user_id, uint32_t started, uint32_t expire, uint16_t attributes_size );
+
+    bool is_expired( uint32_t now ) const;
+
+    uint32_t get_expire() const;
+
+    // sets the expiration time, returns false if the record was replaced, then the replacement has to be postponed
+    bool postpone( uint32_t expire );
+
+    // raises the expiration time to the given one, used to carry postponements over to a replacement
+    void raise_expire( uint32_t expire );
+
+    const char * get_attributes() const;
+};
+
+// hash table of sessions with lock-free lookup by id and an index of the sessions of each user.
+//
+// Readers only load atomics inside of a ReadGuard. Changes must be serialized by the caller, removed records
+// are freed by epoch-based reclamation once no reader which could have seen them is active.
+//
+// All records form one list ordered by id, and the buckets are sentinels in that list, from which a lookup starts.
+// Of 2^n buckets, bucket b holds the ids whose first n bits, reversed, equal b. So doubling the number of buckets
+// splits bucket b into b and b + 2^n by inserting one sentinel into the middle of its range, and no record moves.
+// The doubling itself is a single store. The new buckets are initialized one per insert, in order (split pointer),
+// and a lookup into a bucket which is not initialized yet starts from the sentinel of its parent (b without
+// the highest bit), so no change takes longer than a walk of a few chains.
+//
+// The user index is used by writers and enumeration only: a linear hash of ( namespace, user ), whose buckets
+// chain the records through next_of_user; it grows by splitting one bucket per insert.
+//
+// Records and sentinels live in a RecordArena and are linked by 4-byte indexes, so a session without attributes
+// takes sizeof( Session ) plus its share of the buckets, see get_session_memory().
+class SessionTable
+{
+public:
+
+    // marks a reader critical section, the records found inside of it stay valid until it ends
+    class ReadGuard
+    {
+    public:
+        ReadGuard( const SessionTable & table );
+        ~ReadGuard();
+
+        ReadGuard( const ReadGuard & )              = delete;
+        ReadGuard & operator=( const ReadGuard & )  = delete;
+
+    private:
+        std::atomic<uint32_t>   * counter_;
+    };
+
+public:
+    SessionTable();
+    ~SessionTable();
+
+    SessionTable( const SessionTable & )                = delete;
+    SessionTable & operator=( const SessionTable & )    = delete;
+
+    // upper estimate of the memory taken by a session: its record and its share of the buckets of both indexes
+    static std::size_t get_session_memory( std::size_t attributes_size );
+
+    // readers: inside of a ReadGuard, writers: without it
+    Session * find( const SessionId & id ) const;
+
+    // writers only
+
+    // creates a record, the id must not be in the table, the attributes must not exceed MAX_ATTRIBUTES_SIZE
+    Session * insert( const SessionId & id, namespace_id_t namespace_id, user_id_t user_id, uint32_t started, uint32_t expire, const std::string & attributes );
+
+    // replaces the record with a copy with other attributes, returns nullptr if there is no such record
+    Session * set_attributes( const SessionId & id, const std::string & attributes );
+
+    // unlinks the record, it is freed when no reader can see it anymore
+    bool erase( const SessionId & id );
+
+    // walk in the order of ids, no concurrent changes are allowed
+    Session * get_first() const;
+    Session * get_next( const ListNode * node ) const;
+    Session * upper_bound( const SessionId & id ) const;
+
+    // walk of the sessions of one user, in no particular order, no concurrent changes are allowed
+    Session * get_first_of_user( namespace_id_t namespace_id, user_id_t user_id ) const;
+    Session * get_next_of_user( const Session * session ) const;
+
+    std::size_t size() const;
+
+    std::size_t get_num_users() const;
+
+    // memory of the arena and of the bucket segments, in bytes
+    std::size_t get_memory() const;
+
+private:
+
+    static const uint32_t NUM_SEGMENTS  = 29;       // up to 2^32 buckets
+
+    // first node of the range of a bucket
+    struct Sentinel: ListNode
+    {
+        uint32_t                key;        // first 4 bytes of the smallest id of the range, as a big-endian number
+    };
+
+    typedef std::atomic<uint32_t>   Bucket;     // arena index of the sentinel, 0 - not initialized
+
+    // per-thread counters of active readers, one per epoch parity, each slot takes its own cache line
+    struct ReaderSlot
+    {
+        std::atomic<uint32_t>   counters[2];
+        char                    padding[ 64 - 2 * sizeof( std::atomic<uint32_t> ) ];
+    };
+
+private:
+
+    static std::size_t get_segment_index( std::size_t bucket );
+    static std::size_t get_segment_begin( std::size_t segment_index );
+    static std::size_t get_segment_size( std::size_t segment_index );
+
+    static uint32_t get_num_units( std::size_t attributes_size );
+
+    ListNode * get_node( uint32_t link ) const;
+    Session * get_session( uint32_t index ) const;
+
+    uint32_t get_bucket( std::size_t bucket ) const;
+
+    // true if the node of the link is before the id, a sentinel precedes the ids with the same first bytes
+    bool is_before( uint32_t link, const SessionId & id ) const;
+
+    // sentinel of the bucket of the id, or of its closest initialized parent
+    ListNode * find_bucket( const SessionId & id ) const;
+
+    // link pointing to the first node which is not before the given id
+    std::atomic<uint32_t> * find_link( const SessionId & id ) const;
+
+    uint32_t init_bucket( std::size_t bucket );
+
+    // user index
+    std::size_t get_user_bucket( namespace_id_t namespace_id, user_id_t user_id ) const;
+    uint32_t * get_user_head( std::size_t bucket ) const;
+
+    // first session of the user in the chain starting at the given index
+    Session * find_of_user( uint32_t index, namespace_id_t namespace_id, user_id_t user_id ) const;
+
+    // link to the given session in the chain of its user bucket
+    uint32_t * find_user_link( uint32_t index ) const;
+
+    void link_to_user( uint32_t index );
+    void unlink_from_user( uint32_t index );
+    void split_user_bucket();
+
+    ReaderSlot & get_reader_slot() const;
+
+    void retire( uint32_t index );
+    void try_reclaim();
+    void free_retired( uint32_t parity );
+
+private:
+    RecordArena             arena_;
+
+    // buckets in segments, which double in size and never move: segment 0 holds the initial buckets,
+    // segment i > 0 holds buckets [ initial << ( i - 1 ), initial << i )
+    std::atomic<Bucket*>    segments_[ NUM_SEGMENTS ];
+    std::atomic<std::size_t>    num_buckets_;
+    std::size_t             split_index_;       // next bucket to be initialized
+    std::size_t             size_;
+
+    // user index: buckets [ 0, 2^user_level_ + user_split_ ), in segments of the same layout as above
+    uint32_t                * user_segments_[ NUM_SEGMENTS ];
+    uint32_t                user_level_;
+    std::size_t             user_split_;        // next bucket to be split
+    std::size_t             num_users_;
+
+    std::size_t             segment_memory_;
+
+    std::atomic<uint64_t>   epoch_;
+
+    std::unique_ptr<char[]> reader_slots_buffer_;
+    ReaderSlot              * reader_slots_;        // aligned to the cache line
+
+    // arena indexes of the records removed in the epoch of the given parity
+    std::vector<uint32_t>   retired_sessions_[2];
+};
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__SESSION_TABLE_H
@@ -0,0 +1,114 @@
+/*
+
+Session Manager - Shared Memory Stats Page.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__STATS_PAGE_H
+#define SESSION_MANAGER__STATS_PAGE_H
+
+#include <cstdint>      // uint32_t
+#include <cstring>      // memcpy
+#include <atomic>       // std::atomic
+
+namespace session_manager
+{
+
+// layout of the memory-mapped stats file, shared with external readers:
+// fields are only appended, incompatible changes bump STATS_PAGE_VERSION
+
+#define STATS_PAGE_MAGIC        0x534D5350      // "SMSP"
+#define STATS_PAGE_VERSION      1
+
+struct StatsData
+{
+    uint64_t    update_time;                // unix time in seconds
+
+    uint64_t    num_sessions;
+    uint64_t    memory_usage;               // estimated, in bytes
+    uint64_t    num_users;
+
+    uint32_t    sessions_per_user_p50;
+    uint32_t    sessions_per_user_p90;
+    uint32_t    sessions_per_user_p99;
+    uint32_t    sessions_per_user_max;
+
+    uint64_t    num_logins;
+    uint64_t    num_login_failures;
+    uint64_t    num_validations;
+    uint64_t    num_validation_failures;
+    uint64_t    num_expired;
+    uint64_t    num_evicted;
+
+    uint64_t    last_reap_duration_us;
+};
+
+struct StatsPage
+{
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                data_size;  // sizeof( StatsData ) of the writer
+    std::atomic<uint32_t>   seq;        // seqlock: odd while the writer updates data
+
+    StatsData               data;
+};
+
+static_assert( ATOMIC_INT_LOCK_FREE == 2, "seqlock counter must be lock-free to be shared between processes" );
+
+// seqlock writer side, there must be only one writer at a time
+inline void write_stats( StatsPage * page, const StatsData & data )
+{
+    auto seq = page->seq.load( std::memory_order_relaxed );
+
+    page->seq.store( seq + 1, std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_release );
+
+    memcpy( & page->data, & data, sizeof( data ) );
+
+    page->seq.store( seq + 2, std::memory_order_release );
+}
+
+// seqlock reader side, returns false if a consistent copy could not be obtained in max_tries
+inline bool read_stats( StatsData * data, const StatsPage * page, uint32_t max_tries = 1000 )
+{
+    for( uint32_t i = 0; i < max_tries; ++i )
+    {
+        auto seq_1 = page->seq.load( std::memory_order_acquire );
+
+        if( seq_1 & 1 )
+            continue;
+
+        memcpy( data, & page->data, sizeof( * data ) );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        auto seq_2 = page->seq.load( std::memory_order_relaxed );
+
+        if( seq_1 == seq_2 )
+            return true;
+    }
+
+    return false;
+}
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__STATS_PAGE_H
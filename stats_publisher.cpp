@@ -0,0 +1,94 @@
+/*
+
+Session Manager - Stats Publisher.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "stats_publisher.h"    // self
+
+#include <stdexcept>            // std::runtime_error
+#include <cerrno>               // errno
+#include <fcntl.h>              // open
+#include <unistd.h>             // ftruncate, close
+#include <sys/mman.h>           // mmap
+
+#include "utils/dummy_logger.h"         // dummy_log
+
+#define MODULENAME      "StatsPublisher"
+
+namespace session_manager
+{
+
+StatsPublisher::StatsPublisher():
+        page_( nullptr )
+{
+}
+
+StatsPublisher::~StatsPublisher()
+{
+    if( page_ )
+        munmap( page_, sizeof( StatsPage ) );
+}
+
+void StatsPublisher::init( const std::string & filename )
+{
+    int fd = open( filename.c_str(), O_RDWR | O_CREAT, 0644 );
+
+    if( fd < 0 )
+        throw std::runtime_error( "StatsPublisher: cannot open " + filename + ", errno " + std::to_string( errno ) );
+
+    if( ftruncate( fd, sizeof( StatsPage ) ) != 0 )
+    {
+        close( fd );
+        throw std::runtime_error( "StatsPublisher: cannot resize " + filename + ", errno " + std::to_string( errno ) );
+    }
+
+    void * p = mmap( nullptr, sizeof( StatsPage ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    // the mapping stays valid after the descriptor is closed
+    close( fd );
+
+    if( p == MAP_FAILED )
+        throw std::runtime_error( "StatsPublisher: cannot map " + filename + ", errno " + std::to_string( errno ) );
+
+    page_ = static_cast<StatsPage*>( p );
+
+    page_->seq.store( 0, std::memory_order_relaxed );
+
+    memset( & page_->data, 0, sizeof( page_->data ) );
+
+    page_->magic        = STATS_PAGE_MAGIC;
+    page_->version      = STATS_PAGE_VERSION;
+    page_->data_size    = sizeof( StatsData );
+
+    dummy_log_info( MODULENAME, "init: OK: %s", filename.c_str() );
+}
+
+bool StatsPublisher::is_enabled() const
+{
+    return page_ != nullptr;
+}
+
+void StatsPublisher::publish( const StatsData & data )
+{
+    write_stats( page_, data );
+}
+
+} // namespace session_manager
@@ -0,0 +1,55 @@
+/*
+
+Session Manager - Stats Publisher.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__STATS_PUBLISHER_H
+#define SESSION_MANAGER__STATS_PUBLISHER_H
+
+#include <string>           // std::string
+
+#include "stats_page.h"     // StatsPage
+
+namespace session_manager
+{
+
+// writes StatsData into a memory-mapped file, which can be read by other processes without any locking
+class StatsPublisher
+{
+public:
+    StatsPublisher();
+    ~StatsPublisher();
+
+    // throws std::runtime_error if the file cannot be mapped
+    void init( const std::string & filename );
+
+    bool is_enabled() const;
+
+    // must not be called concurrently
+    void publish( const StatsData & data );
+
+private:
+    StatsPage       * page_;
+};
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__STATS_PUBLISHER_H
@@ -0,0 +1,118 @@
+/*
+
+Session Manager stats reader.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+// Prints the stats page published by SessionManager (see stats_file in config.ini).
+// The page is read without any locking on the side of the manager.
+
+#include "session_manager/stats_page.h"     // session_manager::StatsPage
+
+#include <iostream>             // std::cout
+#include <string>               // std::stoul
+#include <thread>               // std::this_thread
+#include <fcntl.h>              // open
+#include <unistd.h>             // close
+#include <sys/mman.h>           // mmap
+#include <sys/stat.h>           // fstat
+
+void print( const session_manager::StatsData & d )
+{
+    std::cout
+        << "update time             : " << d.update_time << "\n"
+        << "sessions                : " << d.num_sessions << "\n"
+        << "memory usage            : " << d.memory_usage << "\n"
+        << "users                   : " << d.num_users << "\n"
+        << "sessions per user       : p50 " << d.sessions_per_user_p50 << ", p90 " << d.sessions_per_user_p90
+                << ", p99 " << d.sessions_per_user_p99 << ", max " << d.sessions_per_user_max << "\n"
+        << "logins                  : " << d.num_logins << "\n"
+        << "login failures          : " << d.num_login_failures << "\n"
+        << "validations             : " << d.num_validations << "\n"
+        << "validation failures     : " << d.num_validation_failures << "\n"
+        << "expired                 : " << d.num_expired << "\n"
+        << "evicted                 : " << d.num_evicted << "\n"
+        << "last reap duration, us  : " << d.last_reap_duration_us << std::endl;
+}
+
+int main( int argc, char ** argv )
+{
+    if( argc != 2 && argc != 3 )
+    {
+        std::cout << "USAGE: stats_reader <stats_file> [<interval_sec>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int fd = open( argv[1], O_RDONLY );
+
+    if( fd < 0 )
+    {
+        std::cout << "ERROR: cannot open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+
+    if( fstat( fd, & st ) != 0 || st.st_size < static_cast<off_t>( sizeof( session_manager::StatsPage ) ) )
+    {
+        std::cout << "ERROR: " << argv[1] << " is not a stats file" << std::endl;
+        close( fd );
+        return EXIT_FAILURE;
+    }
+
+    void * p = mmap( nullptr, sizeof( session_manager::StatsPage ), PROT_READ, MAP_SHARED, fd, 0 );
+
+    close( fd );
+
+    if( p == MAP_FAILED )
+    {
+        std::cout << "ERROR: cannot map " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto page = static_cast<const session_manager::StatsPage*>( p );
+
+    if( page->magic != STATS_PAGE_MAGIC || page->version != STATS_PAGE_VERSION || page->data_size < sizeof( session_manager::StatsData ) )
+    {
+        std::cout << "ERROR: unsupported stats file: magic " << std::hex << page->magic << std::dec << ", version " << page->version << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t interval = ( argc == 3 ) ? std::stoul( argv[2] ) : 0;
+
+    while( true )
+    {
+        session_manager::StatsData d;
+
+        if( session_manager::read_stats( & d, page ) )
+            print( d );
+        else
+            std::cout << "ERROR: cannot get consistent stats" << std::endl;
+
+        if( interval == 0 )
+            break;
+
+        std::this_thread::sleep_for( std::chrono::seconds( interval ) );
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
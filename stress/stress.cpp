@@ -0,0 +1,645 @@
+/*
+
+Session Manager stress test and scaling benchmark.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+// Stress mode: validators run against writers, which log in, change attributes and close sessions,
+// and against the reaper, which removes sessions expired by a fast clock. Invariants checked:
+//
+//   - a session which was never closed is always valid and belongs to its user,
+//   - a session of the writer is valid until it is closed and invalid afterwards,
+//   - attributes are read back as they were set,
+//   - a session which is found belongs to the user which created it,
+//   - a walk over all sessions returns every never closed session exactly once.
+//
+// The stress mode is meant to be run under ThreadSanitizer: build the library and the test with
+// -fsanitize=thread, a data race or an access to freed memory is reported by the sanitizer.
+//
+// Scaling mode: validation throughput of 1, 2, 4 ... <max_threads> threads over a fixed set of sessions,
+// while one writer keeps creating and closing sessions, so removed records are reclaimed during the run.
+
+#include "session_manager/session_manager.h"    // session_manager::SessionManager
+#include "session_manager/i_authenticator.h"    // session_manager::IAuthenticator
+#include "session_manager/manual_clock.h"       // session_manager::ManualClock
+
+#include <iostream>             // std::cout
+#include <algorithm>            // std::max
+#include <atomic>               // std::atomic
+#include <chrono>               // std::chrono
+#include <random>               // std::mt19937
+#include <set>                  // std::set
+#include <thread>               // std::thread
+#include <vector>               // std::vector
+#include <stdexcept>            // std::invalid_argument
+
+#define NUM_STABLE_SESSIONS     1000
+#define NUM_POSTPONED_SESSIONS  16
+#define STABLE_USER_BASE        1
+#define WRITER_USER_BASE        100000
+#define EXPIRING_USER_BASE      200000
+#define POSTPONED_USER_BASE     300000
+#define MAX_WRITER_BATCH        200
+#define WALK_CHUNK              64
+#define MAX_INSERT_LATENCY_MS   50      // the table grows incrementally, so no login may take longer
+
+namespace sm = session_manager;
+
+class Authenticator: public sm::IAuthenticator
+{
+public:
+
+    // interface session_manager::IAuthenticator
+    virtual bool is_authenticated( uint32_t user_id, const std::string & password ) const
+    {
+        return true;
+    }
+
+    virtual bool is_thread_safe() const
+    {
+        return true;
+    }
+};
+
+const sm::namespace_id_t EXPIRING_NAMESPACE  = 1;
+const sm::namespace_id_t POSTPONED_NAMESPACE = 2;
+const uint16_t           POSTPONED_EXPIRATION_MIN    = 65535;
+
+struct Session
+{
+    std::string     id;
+    sm::user_id_t   user_id;
+};
+
+struct Context
+{
+    Context():
+        clock( std::chrono::system_clock::now() ),
+        is_stopped( false ),
+        num_violations( 0 ),
+        num_validations( 0 )
+    {
+    }
+
+    Authenticator           auth;
+    sm::ManualClock         clock;
+    sm::SessionManager      manager;
+
+    std::vector<Session>    stable_sessions;
+
+    // postponed by one thread while their records are replaced by set_attributes() in another one
+    std::vector<Session>    postponed_sessions;
+
+    // published by the expiring writer, so that validators race with the reaper
+    std::vector<Session>    expiring_sessions;
+    std::atomic<uint32_t>   num_expiring_sessions;
+
+    std::atomic<bool>       is_stopped;
+    std::atomic<uint64_t>   num_violations;
+    std::atomic<uint64_t>   num_validations;
+};
+
+void report( Context & ctx, const std::string & what, const std::string & session_id )
+{
+    if( ctx.num_violations++ < 10 )
+        std::cout << "VIOLATION: " << what << ", session " << session_id << std::endl;
+}
+
+sm::Config create_config( uint16_t expiration_time_min, bool use_thread_cache, bool postpone_expiration = false )
+{
+    sm::Config res;
+
+    res.expiration_time_min     = expiration_time_min;
+    res.max_sessions_per_user   = MAX_WRITER_BATCH;
+    res.postpone_expiration     = postpone_expiration;
+    res.use_thread_cache        = use_thread_cache;
+    res.filter_size             = 1 << 16;
+
+    return res;
+}
+
+void create_stable_sessions( Context & ctx )
+{
+    for( uint32_t i = 0; i < NUM_STABLE_SESSIONS; ++i )
+    {
+        Session s;
+
+        std::string error;
+
+        s.user_id = STABLE_USER_BASE + i;
+
+        if( ctx.manager.authenticate( s.user_id, "", s.id, error ) == false )
+            throw std::runtime_error( "cannot create session: " + error );
+
+        ctx.stable_sessions.push_back( s );
+    }
+}
+
+void create_postponed_sessions( Context & ctx )
+{
+    for( uint32_t i = 0; i < NUM_POSTPONED_SESSIONS; ++i )
+    {
+        Session s;
+
+        std::string error;
+
+        s.user_id = POSTPONED_USER_BASE + i;
+
+        if( ctx.manager.authenticate( s.user_id, "", s.id, error, POSTPONED_NAMESPACE ) == false )
+            throw std::runtime_error( "cannot create session: " + error );
+
+        ctx.postponed_sessions.push_back( s );
+    }
+}
+
+void run_postponer( Context & ctx )
+{
+    // the clock is moved before every postponement, so each one sets a later expiration time
+    auto min_lifetime = std::chrono::minutes( POSTPONED_EXPIRATION_MIN ) - std::chrono::seconds( 1 );
+
+    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+    {
+        for( auto & s : ctx.postponed_sessions )
+        {
+            ctx.clock.advance( std::chrono::seconds( 1 ) );
+
+            auto now = ctx.clock.get_now();
+
+            if( ctx.manager.is_authenticated( s.id, POSTPONED_NAMESPACE ) == false )
+            {
+                report( ctx, "postponed session was not validated", s.id );
+                continue;
+            }
+
+            // the thread cache may hold an older copy, so the record is read directly
+            std::vector<sm::SessionManager::SessionRecord> records;
+
+            ctx.manager.get_user_sessions( & records, s.user_id, POSTPONED_NAMESPACE );
+
+            if( records.size() != 1 || records[0].session_info.expiration_time < now + min_lifetime )
+                report( ctx, "postponement was lost", s.id );
+        }
+    }
+}
+
+void run_attribute_writer( Context & ctx )
+{
+    uint64_t round = 0;
+
+    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+    {
+        auto attributes = "round=" + std::to_string( ++round );
+
+        for( auto & s : ctx.postponed_sessions )
+        {
+            std::string error;
+
+            if( ctx.manager.set_attributes( s.id, attributes, error, POSTPONED_NAMESPACE ) == false )
+                report( ctx, "cannot set attributes: " + error, s.id );
+        }
+    }
+}
+
+void run_validator( Context & ctx, uint32_t seed )
+{
+    std::mt19937 gen( seed );
+
+    std::vector<uint8_t>        results;
+    std::vector<sm::user_id_t>  user_ids;
+    std::vector<std::string>    ids;
+
+    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+    {
+        auto & s = ctx.stable_sessions[ gen() % ctx.stable_sessions.size() ];
+
+        sm::user_id_t user_id = 0;
+
+        if( ctx.manager.get_user_id( & user_id, s.id ) == false || user_id != s.user_id )
+            report( ctx, "stable session was not validated", s.id );
+
+        // a random id is almost surely unknown, it exercises the filter and the misses of the table
+        std::string random_id = "00000000-0000-0000-0000-" + std::to_string( 100000000000ULL + gen() );
+
+        if( ctx.manager.is_authenticated( random_id ) )
+            report( ctx, "unknown session was validated", random_id );
+
+        auto num_expiring = ctx.num_expiring_sessions.load( std::memory_order_acquire );
+
+        if( num_expiring )
+        {
+            auto & e = ctx.expiring_sessions[ gen() % num_expiring ];
+
+            // may be reaped at any moment, but must never be seen with another user
+            if( ctx.manager.get_user_id( & user_id, e.id, EXPIRING_NAMESPACE ) && user_id != e.user_id )
+                report( ctx, "expiring session has a wrong user", e.id );
+        }
+
+        ids.clear();
+
+        for( uint32_t i = 0; i < 8; ++i )
+            ids.push_back( ctx.stable_sessions[ gen() % ctx.stable_sessions.size() ].id );
+
+        ctx.manager.is_authenticated_batch( & results, & user_ids, ids );
+
+        for( std::size_t i = 0; i < ids.size(); ++i )
+        {
+            if( results[i] == 0 )
+                report( ctx, "stable session was not validated in a batch", ids[i] );
+        }
+
+        ctx.num_validations.fetch_add( 4 + ids.size(), std::memory_order_relaxed );
+    }
+}
+
+void run_writer( Context & ctx, uint32_t index )
+{
+    std::mt19937 gen( index );
+
+    sm::user_id_t user_id = WRITER_USER_BASE + index;
+
+    std::vector<std::string> ids;
+
+    uint64_t round = 0;
+
+    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+    {
+        std::string error;
+
+        ids.resize( 1 + gen() % MAX_WRITER_BATCH );
+
+        for( auto & id : ids )
+        {
+            if( ctx.manager.authenticate( user_id, "", id, error ) == false )
+                report( ctx, "writer cannot log in: " + error, "" );
+        }
+
+        auto attributes = "roles=admin;round=" + std::to_string( ++round );
+
+        for( auto & id : ids )
+        {
+            sm::user_id_t found_user_id = 0;
+
+            if( ctx.manager.get_user_id( & found_user_id, id ) == false || found_user_id != user_id )
+                report( ctx, "new session was not validated", id );
+
+            if( ctx.manager.set_attributes( id, attributes, error ) == false )
+                report( ctx, "cannot set attributes: " + error, id );
+
+            sm::SessionManager::SessionInfo info;
+
+            if( ctx.manager.get_session_info( & info, id ) == false || info.attributes != attributes )
+                report( ctx, "attributes were not read back", id );
+        }
+
+        for( auto & id : ids )
+        {
+            if( ctx.manager.close_session( id, error ) == false )
+                report( ctx, "cannot close session: " + error, id );
+
+            // the thread cache must not keep a closed session alive
+            if( ctx.manager.is_authenticated( id ) )
+                report( ctx, "closed session was validated", id );
+        }
+    }
+}
+
+void run_expiring_writer( Context & ctx )
+{
+    // sessions expire after 1 minute of the fast clock and are removed by the reaper on later logins
+    for( uint32_t i = 0; i < ctx.expiring_sessions.size() && ctx.is_stopped.load( std::memory_order_relaxed ) == false; ++i )
+    {
+        auto & s = ctx.expiring_sessions[i];
+
+        std::string error;
+
+        s.user_id = EXPIRING_USER_BASE + i % 1000;
+
+        if( ctx.manager.authenticate( s.user_id, "", s.id, error, EXPIRING_NAMESPACE ) == false )
+            continue;   // the user has reached its limit, the reaper has not caught up yet
+
+        ctx.num_expiring_sessions.store( i + 1, std::memory_order_release );
+
+        ctx.clock.advance( std::chrono::seconds( 1 ) );
+    }
+}
+
+void run_walker( Context & ctx )
+{
+    std::set<std::string> stable_ids;
+
+    for( auto & s : ctx.stable_sessions )
+        stable_ids.insert( s.id );
+
+    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+    {
+        sm::SessionManager::Cursor cursor;
+
+        std::set<std::string> seen;
+
+        std::vector<sm::SessionManager::SessionRecord> sessions;
+
+        while( cursor.is_finished == false )
+        {
+            sessions.clear();
+
+            ctx.manager.get_sessions( & sessions, & cursor, WALK_CHUNK );
+
+            for( auto & r : sessions )
+            {
+                if( stable_ids.count( r.session_id ) && seen.insert( r.session_id ).second == false )
+                    report( ctx, "walk returned a session twice", r.session_id );
+            }
+        }
+
+        if( seen.size() != stable_ids.size() )
+            report( ctx, "walk missed " + std::to_string( stable_ids.size() - seen.size() ) + " sessions", "" );
+    }
+}
+
+bool run_stress( uint32_t num_threads, uint32_t duration_sec )
+{
+    Context ctx;
+
+    // the stable sessions outlive the run, the sessions of the other namespace expire quickly
+    ctx.manager.init( & ctx.auth, create_config( 65535, true ), & ctx.clock );
+    ctx.manager.add_namespace( EXPIRING_NAMESPACE, create_config( 1, false ) );
+    ctx.manager.add_namespace( POSTPONED_NAMESPACE, create_config( POSTPONED_EXPIRATION_MIN, false, true ) );
+
+    create_stable_sessions( ctx );
+    create_postponed_sessions( ctx );
+
+    ctx.expiring_sessions.resize( 1000000 );
+    ctx.num_expiring_sessions   = 0;
+
+    uint32_t num_writers = std::max( 1u, num_threads / 4 );
+
+    std::vector<std::thread> threads;
+
+    for( uint32_t i = 0; i < num_threads; ++i )
+        threads.push_back( std::thread( run_validator, std::ref( ctx ), i ) );
+
+    for( uint32_t i = 0; i < num_writers; ++i )
+        threads.push_back( std::thread( run_writer, std::ref( ctx ), i ) );
+
+    threads.push_back( std::thread( run_expiring_writer, std::ref( ctx ) ) );
+    threads.push_back( std::thread( run_walker, std::ref( ctx ) ) );
+    threads.push_back( std::thread( run_postponer, std::ref( ctx ) ) );
+    threads.push_back( std::thread( run_attribute_writer, std::ref( ctx ) ) );
+
+    std::this_thread::sleep_for( std::chrono::seconds( duration_sec ) );
+
+    ctx.is_stopped  = true;
+
+    for( auto & t : threads )
+        t.join();
+
+    sm::SessionManager::Stats stats;
+
+    ctx.manager.get_stats( & stats );
+
+    std::cout << "validators " << num_threads << ", writers " << num_writers
+            << ", validations " << ctx.num_validations.load()
+            << ", expiring sessions created " << ctx.num_expiring_sessions.load()
+            << ", sessions left " << stats.num_sessions
+            << ", violations " << ctx.num_violations.load() << std::endl;
+
+    return ctx.num_violations.load() == 0;
+}
+
+void run_scaling( uint32_t max_threads, uint32_t duration_sec )
+{
+    Context ctx;
+
+    // the thread cache is disabled, so that every validation goes to the table
+    ctx.manager.init( & ctx.auth, create_config( 65535, false ), & ctx.clock );
+
+    create_stable_sessions( ctx );
+
+    for( uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2 )
+    {
+        ctx.is_stopped      = false;
+        ctx.num_validations = 0;
+
+        std::vector<std::thread> threads;
+
+        for( uint32_t i = 0; i < num_threads; ++i )
+        {
+            threads.push_back( std::thread( [&ctx, i]()
+                {
+                    std::mt19937 gen( i );
+
+                    uint64_t num = 0;
+
+                    while( ctx.is_stopped.load( std::memory_order_relaxed ) == false )
+                    {
+                        auto & s = ctx.stable_sessions[ gen() % ctx.stable_sessions.size() ];
+
+                        if( ctx.manager.is_authenticated( s.id ) == false )
+                            report( ctx, "stable session was not validated", s.id );
+
+                        ++num;
+                    }
+
+                    ctx.num_validations.fetch_add( num, std::memory_order_relaxed );
+                } ) );
+        }
+
+        threads.push_back( std::thread( run_writer, std::ref( ctx ), 0 ) );
+
+        auto begin = std::chrono::steady_clock::now();
+
+        std::this_thread::sleep_for( std::chrono::seconds( duration_sec ) );
+
+        ctx.is_stopped  = true;
+
+        for( auto & t : threads )
+            t.join();
+
+        double elapsed_sec = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+
+        auto per_sec = ctx.num_validations.load() / elapsed_sec;
+
+        std::cout << "threads " << num_threads
+                << ": " << static_cast<uint64_t>( per_sec ) << " validations per second"
+                << ", " << static_cast<uint64_t>( per_sec / num_threads ) << " per thread" << std::endl;
+    }
+}
+
+bool run_growth( uint32_t num_sessions )
+{
+    Context ctx;
+
+    ctx.manager.init( & ctx.auth, create_config( 65535, false ), & ctx.clock );
+
+    std::chrono::steady_clock::duration max_latency( 0 );
+
+    uint32_t max_latency_size = 0;
+
+    std::string id;
+
+    for( uint32_t i = 0; i < num_sessions; ++i )
+    {
+        std::string error;
+
+        auto begin = std::chrono::steady_clock::now();
+
+        if( ctx.manager.authenticate( STABLE_USER_BASE + i, "", id, error ) == false )
+            throw std::runtime_error( "cannot create session: " + error );
+
+        auto latency = std::chrono::steady_clock::now() - begin;
+
+        if( latency > max_latency )
+        {
+            max_latency         = latency;
+            max_latency_size    = i;
+        }
+
+        // sessions of a real load expire at different times
+        if( i % 100 == 0 )
+            ctx.clock.advance( std::chrono::seconds( 1 ) );
+
+        if( i % 1000 == 0 )
+        {
+            Session s;
+
+            s.id        = id;
+            s.user_id   = STABLE_USER_BASE + i;
+
+            ctx.stable_sessions.push_back( s );
+        }
+    }
+
+    for( auto & s : ctx.stable_sessions )
+    {
+        sm::user_id_t user_id = 0;
+
+        if( ctx.manager.get_user_id( & user_id, s.id ) == false || user_id != s.user_id )
+            report( ctx, "session was not validated after the growth", s.id );
+
+        // the user index was split many times meanwhile
+        std::vector<sm::SessionManager::SessionRecord> user_sessions;
+
+        ctx.manager.get_user_sessions( & user_sessions, s.user_id );
+
+        if( user_sessions.size() != 1 || user_sessions[0].session_id != s.id )
+            report( ctx, "session was not found among the sessions of the user after the growth", s.id );
+    }
+
+    // the walk returns every session once, in the order of ids
+    sm::SessionManager::Cursor cursor;
+
+    std::vector<sm::SessionManager::SessionRecord> sessions;
+
+    uint32_t num_walked = 0;
+
+    std::string last_id;
+
+    while( cursor.is_finished == false )
+    {
+        sessions.clear();
+
+        ctx.manager.get_sessions( & sessions, & cursor, 10000 );
+
+        for( auto & r : sessions )
+        {
+            if( r.session_id <= last_id )
+                report( ctx, "walk is not ordered", r.session_id );
+
+            last_id = r.session_id;
+        }
+
+        num_walked += sessions.size();
+    }
+
+    if( num_walked != num_sessions )
+        report( ctx, "walk returned " + std::to_string( num_walked ) + " sessions", "" );
+
+    auto max_latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>( max_latency ).count();
+
+    std::cout << "sessions " << num_sessions << ", max login latency " << std::chrono::duration_cast<std::chrono::microseconds>( max_latency ).count()
+            << " us at " << max_latency_size << " sessions, violations " << ctx.num_violations.load() << std::endl;
+
+    if( max_latency_ms > MAX_INSERT_LATENCY_MS )
+        report( ctx, "login took " + std::to_string( max_latency_ms ) + " ms", "" );
+
+    return ctx.num_violations.load() == 0;
+}
+
+int main( int argc, char ** argv )
+{
+    bool is_scaling = ( argc == 4 && std::string( argv[1] ) == "--scaling" );
+    bool is_growth  = ( argc == 3 && std::string( argv[1] ) == "--growth" );
+
+    if( argc != 3 && is_scaling == false )
+    {
+        std::cout << "USAGE: stress <num_validators> <duration_sec>\n"
+                << "       stress --scaling <max_threads> <duration_sec_per_step>\n"
+                << "       stress --growth <num_sessions>" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    if( is_growth )
+    {
+        if( run_growth( std::stoul( argv[2] ) ) == false )
+        {
+            std::cout << "ERROR: invariants were violated" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "OK: no violations" << std::endl;
+
+        return 0;
+    }
+
+    try
+    {
+        uint32_t num_threads    = std::stoul( argv[ is_scaling ? 2 : 1 ] );
+        uint32_t duration_sec   = std::stoul( argv[ is_scaling ? 3 : 2 ] );
+
+        if( num_threads == 0 )
+            throw std::invalid_argument( "number of threads must not be 0" );
+
+        if( is_scaling )
+        {
+            run_scaling( num_threads, duration_sec );
+
+            return 0;
+        }
+
+        if( run_stress( num_threads, duration_sec ) == false )
+        {
+            std::cout << "ERROR: invariants were violated" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "OK: no violations" << std::endl;
+
+        return 0;
+    }
+    catch( std::exception & e )
+    {
+        std::cout << "ERROR: " << e.what() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+}
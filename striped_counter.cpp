@@ -0,0 +1,74 @@
+/*
+
+Session Manager - Striped Counter.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#include "striped_counter.h"    // self
+
+#include <new>                  // placement new
+
+#define NUM_STRIPES             32      // threads beyond it share stripes, which is correct, but slower
+#define CACHE_LINE_SIZE         64
+
+namespace session_manager
+{
+
+namespace
+{
+
+std::atomic<uint32_t>   last_stripe_index( 0 );
+
+thread_local uint32_t   stripe_index    = last_stripe_index++;
+
+}
+
+StripedCounter::StripedCounter():
+        stripes_buffer_( new char[ ( NUM_STRIPES + 1 ) * CACHE_LINE_SIZE ] )
+{
+    static_assert( sizeof( Stripe ) == CACHE_LINE_SIZE, "stripe must take one cache line" );
+
+    auto p = reinterpret_cast<uintptr_t>( stripes_buffer_.get() );
+
+    p = ( p + CACHE_LINE_SIZE - 1 ) & ~uintptr_t( CACHE_LINE_SIZE - 1 );
+
+    stripes_ = reinterpret_cast<Stripe*>( p );
+
+    for( uint32_t i = 0; i < NUM_STRIPES; ++i )
+        new( & stripes_[i] ) Stripe();
+}
+
+void StripedCounter::add( uint64_t value )
+{
+    stripes_[ stripe_index % NUM_STRIPES ].value.fetch_add( value, std::memory_order_relaxed );
+}
+
+uint64_t StripedCounter::get() const
+{
+    uint64_t res = 0;
+
+    for( uint32_t i = 0; i < NUM_STRIPES; ++i )
+        res += stripes_[i].value.load( std::memory_order_relaxed );
+
+    return res;
+}
+
+} // namespace session_manager
@@ -0,0 +1,64 @@
+/*
+
+Session Manager - Striped Counter.
+
+Copyright (C) 2020 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+// $Revision: 13920 $ $Date:: 2020-10-03 #$ $Author: serge $
+
+#ifndef SESSION_MANAGER__STRIPED_COUNTER_H
+#define SESSION_MANAGER__STRIPED_COUNTER_H
+
+#include <atomic>       // std::atomic
+#include <memory>       // std::unique_ptr
+#include <cstdint>      // uint64_t
+
+namespace session_manager
+{
+
+// counter which is incremented by many threads at once: each thread adds to a stripe on its own cache line,
+// so that the increments do not contend, the value is the sum of the stripes and is read rarely
+class StripedCounter
+{
+public:
+    StripedCounter();
+
+    StripedCounter( const StripedCounter & )                = delete;
+    StripedCounter & operator=( const StripedCounter & )    = delete;
+
+    void add( uint64_t value );
+
+    uint64_t get() const;
+
+private:
+
+    struct Stripe
+    {
+        std::atomic<uint64_t>   value;
+        char                    padding[ 64 - sizeof( std::atomic<uint64_t> ) ];
+    };
+
+private:
+    std::unique_ptr<char[]> stripes_buffer_;
+    Stripe                  * stripes_;         // aligned to the cache line
+};
+
+} // namespace session_manager
+
+#endif // SESSION_MANAGER__STRIPED_COUNTER_H
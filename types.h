@@ -30,6 +30,7 @@ namespace session_manager
 {
 
 typedef uint32_t user_id_t;
+typedef uint16_t namespace_id_t;
 
 } // namespace phonebook
 